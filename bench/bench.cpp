@@ -0,0 +1,1177 @@
+#include "catalog.h"
+#include "checkout_register.h"
+#include "checkout_stats.h"
+#include "store_server.h"
+#include "deal_solver.h"
+#include "pricing_kernel.h"
+#include "cpu_features.h"
+#include "io_helper.h"
+#include "journal.h"
+#include "id_bitmap.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+
+#ifndef CHECKOUT_STATS
+namespace {
+    /**
+     * The number of heap allocations made by the process, counted by the global operator new below.
+     * Builds with checkout statistics count allocations in CheckoutStats instead.
+    */
+    std::atomic<size_t> allocationCount(0);
+}
+
+/**
+ * Gets the number of heap allocations made so far.
+*/
+size_t allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+// GCC inlines the deletes below next to new expressions in this file and, not seeing that the
+// operator new above allocates with malloc, warns that the memory is released with free
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#else
+size_t allocations() {
+    return CheckoutStats::threadAllocations();
+}
+#endif
+
+/**
+ * Gives the benchmarks access to the individual checkout stages of a register.
+*/
+class RegisterBenchmark {
+    public:
+        static void calculateDeals(CheckoutRegister& reg) { reg.calculateDeals(); }
+        static void printReceipt(CheckoutRegister& reg, std::ostream& out) { reg.printReceipt(out); }
+        static void setDealNodeBudget(CheckoutRegister& reg, int nodeBudget) { reg.dealSolver.setNodeBudget(nodeBudget); }
+};
+
+/**
+ * A stream buffer that discards everything written to it, so receipts can be formatted without
+ * measuring the cost of a terminal or file.
+*/
+class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+/**
+ * Parameters of the synthetic catalog and carts.
+*/
+struct BenchConfig {
+    int itemCount = 10000;
+    int dealCount = 1000;
+    int dealSize = 3;
+    int cartLines = 50;
+    std::string quantity = "uniform";
+    int maxQuantity = 6;
+    int samples = 200;
+    int loadSamples = 5;
+    int loadThreads = 0;
+    unsigned long long seed = 1;
+    int lanes = 200;
+    int laneCarts = 5;
+    int overlapClusters = 100;
+    int steadyCarts = 1000000;
+    int wideCartLines = 50000;
+    int textMiB = 2048;
+    int journalEvents = 1000000;
+    std::string filter;
+};
+
+/**
+ * The size of the journal written by the journal benchmarks, and the number of group commits it took.
+*/
+struct JournalSummary {
+    long long events = 0;
+    long long bytes = 0;
+    long long commits = 0;
+};
+
+/**
+ * The number of items in each cluster of overlapping deals.
+*/
+const int overlapClusterSize = 6;
+
+/**
+ * The measurements of a single benchmark.
+*/
+struct BenchResult {
+    std::string name;
+    long long ops;
+    double nsPerOp;
+    double allocsPerOp;
+    double p50;
+    double p99;
+};
+
+/**
+ * The savings of the exact deal solver compared to applying each deal greedily, over the clusters
+ * of overlapping deals of all carts.
+*/
+struct SolverComparison {
+    long long clusters = 0;
+    long long optimalClusters = 0;
+    long long improvedClusters = 0;
+    long long greedySavings = 0;
+    long long bestSavings = 0;
+    long long maxGap = 0;
+    long long maxNodes = 0;
+};
+
+/**
+ * The catalog layout before items and deals were stored as columns: an array of item structs, and
+ * a separately allocated list for the items of every deal and deal cluster. Kept to compare memory
+ * use and deal walks with the column layout.
+*/
+struct LegacyCatalog {
+    struct Deal {
+        DealTerms terms;
+        std::vector<int> itemIds;
+        std::vector<int> itemCounts;
+    };
+    struct Cluster {
+        std::vector<int> dealIds;
+        std::vector<int> itemIds;
+        std::vector<std::vector<int>> dealSlots;
+        std::vector<std::vector<int>> dealSlotCounts;
+    };
+    std::vector<CatalogItem> items;
+    std::vector<std::int64_t> itemPrices;
+    std::vector<Deal> deals;
+    std::vector<Cluster> clusters;
+};
+
+/**
+ * The memory used by the column layout of the catalog and by the legacy layout of the same catalog.
+*/
+struct LayoutSummary {
+    long long items = 0;
+    long long deals = 0;
+    Catalog::MemoryUsage columns = {};
+    Catalog::MemoryUsage legacy = {};
+    long long legacyAllocations = 0;
+};
+
+/**
+ * Prints the command line usage of the benchmark to the standard error.
+*/
+void printUsage() {
+    std::cerr << "Usage: supermarket_bench [options]" << std::endl;
+    std::cerr << "  --items N          number of items in the synthetic catalog (default 10000)" << std::endl;
+    std::cerr << "  --deals N          number of deals in the synthetic catalog (default 1000)" << std::endl;
+    std::cerr << "  --deal-size N      number of items in each deal (default 3)" << std::endl;
+    std::cerr << "  --cart-lines N     number of scanned lines in each cart (default 50)" << std::endl;
+    std::cerr << "  --quantity D       quantity distribution: ones, uniform or skewed (default uniform)" << std::endl;
+    std::cerr << "  --max-quantity N   largest quantity of a scanned line (default 6)" << std::endl;
+    std::cerr << "  --samples N        timed samples per benchmark (default 200)" << std::endl;
+    std::cerr << "  --load-samples N   timed samples of catalog generation and loading (default 5)" << std::endl;
+    std::cerr << "  --load-threads N   threads reading each catalog file, 0 for one per core (default 0)" << std::endl;
+    std::cerr << "  --seed N           random seed (default 1)" << std::endl;
+    std::cerr << "  --lanes N          simulated lanes of the store load generator (default 200)" << std::endl;
+    std::cerr << "  --lane-carts N     carts checked out by each simulated lane (default 5)" << std::endl;
+    std::cerr << "  --overlap-clusters N  clusters of overlapping deals in the deal solver benchmarks (default 100)" << std::endl;
+    std::cerr << "  --steady-carts N   carts checked out by one register with no allocations allowed (default 1000000)" << std::endl;
+    std::cerr << "  --wide-cart-lines N  lines of the wholesale cart priced by the pricing kernels (default 50000)" << std::endl;
+    std::cerr << "  --text-mib N       MiB of synthetic catalog lines split and converted to Camel Case (default 2048)" << std::endl;
+    std::cerr << "  --journal-events N  events appended to the journal and recovered from it (default 1000000)" << std::endl;
+    std::cerr << "  --filter S         only run benchmarks whose name contains S" << std::endl;
+}
+
+/**
+ * Reads the benchmark parameters from the command line arguments.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @returns The parameters.
+*/
+BenchConfig parseArguments(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 == argc) {
+            throw std::runtime_error("Missing value for argument '" + arg + "'.");
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--items") config.itemCount = std::stoi(value);
+            else if (arg == "--deals") config.dealCount = std::stoi(value);
+            else if (arg == "--deal-size") config.dealSize = std::stoi(value);
+            else if (arg == "--cart-lines") config.cartLines = std::stoi(value);
+            else if (arg == "--quantity") config.quantity = value;
+            else if (arg == "--max-quantity") config.maxQuantity = std::stoi(value);
+            else if (arg == "--samples") config.samples = std::stoi(value);
+            else if (arg == "--load-samples") config.loadSamples = std::stoi(value);
+            else if (arg == "--load-threads") config.loadThreads = std::stoi(value);
+            else if (arg == "--seed") config.seed = std::stoull(value);
+            else if (arg == "--lanes") config.lanes = std::stoi(value);
+            else if (arg == "--lane-carts") config.laneCarts = std::stoi(value);
+            else if (arg == "--overlap-clusters") config.overlapClusters = std::stoi(value);
+            else if (arg == "--steady-carts") config.steadyCarts = std::stoi(value);
+            else if (arg == "--wide-cart-lines") config.wideCartLines = std::stoi(value);
+            else if (arg == "--text-mib") config.textMiB = std::stoi(value);
+            else if (arg == "--journal-events") config.journalEvents = std::stoi(value);
+            else if (arg == "--filter") config.filter = value;
+            else throw std::runtime_error("Unknown argument '" + arg + "'.");
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid value '" + value + "' for argument '" + arg + "'.");
+        }
+    }
+
+    // Check the parameters describe a valid catalog and cart
+    if (config.itemCount < 1 || config.dealCount < 0 || config.dealSize < 1 || config.cartLines < 1 ||
+        config.maxQuantity < 1 || config.samples < 1 || config.loadSamples < 1 ||
+        config.lanes < 1 || config.laneCarts < 1 || config.overlapClusters < 1 || config.loadThreads < 0 ||
+        config.steadyCarts < 1 || config.wideCartLines < 1 || config.textMiB < 1 ||
+        config.journalEvents < 1) {
+        throw std::runtime_error("Counts and sizes must be positive.");
+    }
+    if (static_cast<long long>(config.dealCount) * config.dealSize > config.itemCount) {
+        throw std::runtime_error("Deals need more items than the catalog has.");
+    }
+    if (static_cast<long long>(config.overlapClusters) * overlapClusterSize > config.itemCount) {
+        throw std::runtime_error("Overlapping deal clusters need more items than the catalog has.");
+    }
+    if (config.quantity != "ones" && config.quantity != "uniform" && config.quantity != "skewed") {
+        throw std::runtime_error("Unknown quantity distribution '" + config.quantity + "'.");
+    }
+    return config;
+}
+
+/**
+ * Gets the name of a synthetic item.
+ * @param itemId The item id.
+ * @returns The item name, already in Camel Case.
+*/
+std::string itemName(int itemId) {
+    return "Item" + std::to_string(itemId);
+}
+
+/**
+ * Formats an amount of cents as a price of the catalog files.
+ * @param cents The amount in cents.
+ * @returns The price.
+*/
+std::string formatPrice(int cents) {
+    return std::to_string(cents / 100) + '.' + std::to_string(cents % 100 / 10) + std::to_string(cents % 10);
+}
+
+/**
+ * Writes a synthetic catalog to items and deals files. Deal items are the first items of the
+ * catalog, so that carts drawn uniformly from the catalog hit deals in proportion to their size.
+ * A second deals file for the same items holds clusters of overlapping deals of every type.
+ * @param config The benchmark parameters.
+ * @param itemsPath The path of the items file.
+ * @param dealsPath The path of the deals file.
+ * @param overlapDealsPath The path of the overlapping deals file.
+*/
+void generateCatalog(const BenchConfig& config, const std::string& itemsPath, const std::string& dealsPath,
+                     const std::string& overlapDealsPath) {
+    std::mt19937_64 rng(config.seed);
+    std::uniform_int_distribution<int> cents(25, 2000);
+
+    // Write items with random prices
+    std::vector<int> prices(config.itemCount);
+    std::ofstream items(itemsPath);
+    items << "Item,Price\n";
+    for (int id = 0; id < config.itemCount; id++) {
+        prices[id] = cents(rng);
+        items << itemName(id) << ',' << formatPrice(prices[id]) << '\n';
+    }
+
+    // Write deals of consecutive items
+    std::ofstream deals(dealsPath);
+    deals << "Deal\n";
+    for (int deal = 0; deal < config.dealCount; deal++) {
+        for (int i = 0; i < config.dealSize; i++) {
+            deals << (i > 0 ? "," : "") << itemName(deal * config.dealSize + i);
+        }
+        deals << '\n';
+    }
+
+    // Write clusters of a Buy 2 Get 1 deal of all items overlapping a Buy 3 Get 1 deal,
+    // a Buy 1 Get 1 deal and a bundle at a quarter off
+    std::ofstream overlapDeals(overlapDealsPath);
+    overlapDeals << "Deal\n";
+    for (int cluster = 0; cluster < config.overlapClusters; cluster++) {
+        int first = cluster * overlapClusterSize;
+        for (int i = 0; i < overlapClusterSize; i++) {
+            overlapDeals << (i > 0 ? "," : "") << itemName(first + i);
+        }
+        overlapDeals << "\nBuy 3 Get 1: " << itemName(first) << ',' << itemName(first + 1) << ','
+            << itemName(first + 2) << ',' << itemName(first + 3) << '\n';
+        overlapDeals << "Buy 1 Get 1: " << itemName(first + 4) << ',' << itemName(first + 5) << '\n';
+        int bundlePrice = (prices[first + 1] + prices[first + 2] + prices[first + 5]) * 3 / 4;
+        overlapDeals << "Bundle " << formatPrice(bundlePrice) << ": " << itemName(first + 1) << ','
+            << itemName(first + 2) << ',' << itemName(first + 5) << '\n';
+    }
+
+    if (!items || !deals || !overlapDeals) {
+        throw std::runtime_error("Cannot write the synthetic catalog to: '" + itemsPath + "'.");
+    }
+}
+
+/**
+ * A single scanned cart line.
+*/
+struct CartLine {
+    std::string name;
+    int quantity;
+};
+
+/**
+ * Generates a random cart.
+ * @param config The benchmark parameters.
+ * @param rng The random number generator.
+ * @param itemCount The number of items to draw from, starting from the first item.
+ * @returns The lines of the cart in scan order.
+*/
+std::vector<CartLine> generateCart(const BenchConfig& config, std::mt19937_64& rng, int itemCount) {
+    std::uniform_int_distribution<int> items(0, itemCount - 1);
+    std::uniform_int_distribution<int> uniform(1, config.maxQuantity);
+    std::geometric_distribution<int> skewed(0.5);
+
+    std::vector<CartLine> cart;
+    cart.reserve(config.cartLines);
+    for (int i = 0; i < config.cartLines; i++) {
+        int quantity = 1;
+        if (config.quantity == "uniform") {
+            quantity = uniform(rng);
+        } else if (config.quantity == "skewed") {
+            quantity = std::min(1 + skewed(rng), config.maxQuantity);
+        }
+        cart.push_back({itemName(items(rng)), quantity});
+    }
+    return cart;
+}
+
+/**
+ * Generates catalog lines with item names of one to four words in mixed case, some of which hold
+ * non-ASCII letters, split into slices of about 1 MiB of whole lines.
+ * @param rng The random number generator.
+ * @param bytes The size of the lines in bytes.
+ * @returns The slices.
+*/
+std::vector<std::string> generateCatalogText(std::mt19937_64& rng, size_t bytes) {
+    const std::vector<std::string> words = {
+        "fresh", "ORGANIC", "Whole", "milk", "bAnAnAs", "sparkling", "WATER", "greek", "yogurt", "dark",
+        "Chocolate", "extra\tvirgin", "olive", "oil", "free range", "EGGS", "sourdough", "bread", "Cr\xc3\xa8me",
+        "br\xc3\xbbl\xc3\xa9" "e", "jalape\xc3\xb1o", "crisps", "family", "SIZE", "breakfast", "cereal"};
+    std::uniform_int_distribution<size_t> word(0, words.size() - 1);
+    std::uniform_int_distribution<int> wordCount(1, 4);
+    std::uniform_int_distribution<int> cents(25, 2000);
+
+    const size_t sliceBytes = 1 << 20;
+    std::vector<std::string> slices;
+    size_t size = 0;
+    while (size < bytes) {
+        std::string slice;
+        while (slice.size() < sliceBytes) {
+            int count = wordCount(rng);
+            for (int i = 0; i < count; i++) {
+                slice += words[word(rng)];
+                slice += i + 1 < count ? ' ' : ',';
+            }
+            slice += formatPrice(cents(rng));
+            slice += '\n';
+        }
+        size += slice.size();
+        slices.push_back(std::move(slice));
+    }
+    return slices;
+}
+
+/**
+ * Copies a catalog into the legacy layout.
+ * @param catalog The catalog.
+ * @returns The legacy layout, whose item names are views into the catalog.
+*/
+LegacyCatalog buildLegacyCatalog(const Catalog& catalog) {
+    LegacyCatalog legacy;
+    legacy.items.reserve(catalog.getItemCount());
+    legacy.itemPrices.reserve(catalog.getItemCount());
+    for (int itemId = 0; itemId < catalog.getItemCount(); itemId++) {
+        legacy.items.push_back(catalog.getItem(itemId));
+        legacy.itemPrices.push_back(catalog.getItemPrices()[itemId]);
+    }
+
+    // Only bundles stored their item counts
+    legacy.deals.resize(catalog.getDealCount());
+    for (int dealId = 0; dealId < catalog.getDealCount(); dealId++) {
+        Deal deal = catalog.getDeal(dealId);
+        LegacyCatalog::Deal& legacyDeal = legacy.deals[dealId];
+        legacyDeal.terms = deal;
+        legacyDeal.itemIds.assign(deal.itemIds.begin(), deal.itemIds.end());
+        if (deal.type == DealType::Bundle) {
+            legacyDeal.itemCounts.assign(deal.itemCounts.begin(), deal.itemCounts.end());
+        }
+    }
+
+    legacy.clusters.resize(catalog.getDealClusterCount());
+    for (int clusterId = 0; clusterId < catalog.getDealClusterCount(); clusterId++) {
+        DealCluster cluster = catalog.getDealCluster(clusterId);
+        LegacyCatalog::Cluster& legacyCluster = legacy.clusters[clusterId];
+        legacyCluster.dealIds.assign(cluster.dealIds.begin(), cluster.dealIds.end());
+        legacyCluster.itemIds.assign(cluster.itemIds.begin(), cluster.itemIds.end());
+        legacyCluster.dealSlots.resize(cluster.dealIds.size());
+        legacyCluster.dealSlotCounts.resize(cluster.dealIds.size());
+        for (size_t dealIndex = 0; dealIndex < cluster.dealIds.size(); dealIndex++) {
+            IdSpan slots = cluster.dealSlots(dealIndex);
+            IdSpan counts = cluster.dealSlotCounts(dealIndex);
+            legacyCluster.dealSlots[dealIndex].assign(slots.begin(), slots.end());
+            legacyCluster.dealSlotCounts[dealIndex].assign(counts.begin(), counts.end());
+        }
+    }
+    return legacy;
+}
+
+/**
+ * Gets the memory reserved by a vector, not counting what its elements point to.
+*/
+template <typename T>
+size_t vectorBytes(const std::vector<T>& vector) {
+    return vector.capacity() * sizeof(T);
+}
+
+/**
+ * Gets the memory used by a catalog in the legacy layout. The names and item index were stored the
+ * same way in both layouts.
+ * @param legacy The legacy layout.
+ * @param columns The memory used by the catalog in the column layout.
+ * @returns The memory used by each part of the legacy layout.
+*/
+Catalog::MemoryUsage legacyMemoryUsage(const LegacyCatalog& legacy, const Catalog::MemoryUsage& columns) {
+    Catalog::MemoryUsage usage = columns;
+    usage.items = vectorBytes(legacy.items) + vectorBytes(legacy.itemPrices);
+    usage.deals = vectorBytes(legacy.deals) + vectorBytes(legacy.clusters);
+    for (const LegacyCatalog::Deal& deal : legacy.deals) {
+        usage.deals += vectorBytes(deal.itemIds) + vectorBytes(deal.itemCounts);
+    }
+    for (const LegacyCatalog::Cluster& cluster : legacy.clusters) {
+        usage.deals += vectorBytes(cluster.dealIds) + vectorBytes(cluster.itemIds)
+            + vectorBytes(cluster.dealSlots) + vectorBytes(cluster.dealSlotCounts);
+        for (size_t i = 0; i < cluster.dealSlots.size(); i++) {
+            usage.deals += vectorBytes(cluster.dealSlots[i]) + vectorBytes(cluster.dealSlotCounts[i]);
+        }
+    }
+    return usage;
+}
+
+/**
+ * Times a benchmark over a number of samples.
+ * @param name The benchmark name.
+ * @param samples The number of timed samples.
+ * @param opsPerSample The number of operations run in each sample.
+ * @param setup Called before each sample, not timed.
+ * @param op Runs a single operation, given its index within the sample.
+ * @returns The measurements, with percentiles taken over the per-operation time of each sample.
+*/
+BenchResult measure(const std::string& name, int samples, int opsPerSample,
+                    const std::function<void()>& setup, const std::function<void(int)>& op) {
+    std::vector<double> sampleNs;
+    sampleNs.reserve(samples);
+    double totalNs = 0;
+    size_t totalAllocations = 0;
+
+    for (int sample = 0; sample < samples; sample++) {
+        setup();
+
+        size_t allocationsBefore = allocations();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < opsPerSample; i++) {
+            op(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        totalAllocations += allocations() - allocationsBefore;
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        totalNs += ns;
+        sampleNs.push_back(ns / opsPerSample);
+    }
+
+    // Take percentiles over samples
+    std::sort(sampleNs.begin(), sampleNs.end());
+    auto percentile = [&sampleNs](int p) {
+        return sampleNs[std::min(sampleNs.size() - 1, sampleNs.size() * p / 100)];
+    };
+
+    long long ops = static_cast<long long>(samples) * opsPerSample;
+    return {name, ops, totalNs / ops, static_cast<double>(totalAllocations) / ops, percentile(50), percentile(99)};
+}
+
+/**
+ * Simulates many lanes checking out carts at once on a store. Commands of all lanes are interleaved
+ * one line at a time, as if every lane were scanning concurrently, and submitted as fast as the
+ * store accepts them.
+ * @param config The benchmark parameters.
+ * @param catalog The catalog.
+ * @param rng The random number generator.
+ * @param out The output stream for receipts.
+ * @returns The measurements, with percentiles taken over the submit to completion latency of each command.
+*/
+BenchResult runStoreLoad(const BenchConfig& config, std::shared_ptr<const Catalog> catalog, std::mt19937_64& rng, std::ostream& out) {
+    // Generate the commands of every lane
+    std::vector<std::vector<std::string>> laneCommands(config.lanes);
+    for (std::vector<std::string>& commands : laneCommands) {
+        for (int cart = 0; cart < config.laneCarts; cart++) {
+            for (const CartLine& line : generateCart(config, rng, config.itemCount)) {
+                commands.push_back(line.name + " " + std::to_string(line.quantity));
+            }
+            commands.push_back("checkout");
+        }
+    }
+
+    CatalogManager catalogManager(catalog);
+    StoreServer store(catalogManager, config.lanes, out, 0, true);
+    size_t allocationsBefore = allocations();
+    auto start = std::chrono::steady_clock::now();
+
+    // Submit one command of each lane in turn
+    long long commandCount = 0;
+    for (size_t i = 0; ; i++) {
+        bool isSubmitted = false;
+        for (int lane = 0; lane < config.lanes; lane++) {
+            if (i < laneCommands[lane].size()) {
+                store.submit(lane, std::move(laneCommands[lane][i]));
+                isSubmitted = true;
+                commandCount++;
+            }
+        }
+        if (!isSubmitted) {
+            break;
+        }
+    }
+    store.drain();
+
+    auto end = std::chrono::steady_clock::now();
+    size_t totalAllocations = allocations() - allocationsBefore;
+
+    // Take percentiles over commands
+    std::vector<std::uint64_t> latencies = store.getLatencies();
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](int p) {
+        return static_cast<double>(latencies[std::min(latencies.size() - 1, latencies.size() * p / 100)]);
+    };
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return {"storeCommands", commandCount, ns / commandCount, static_cast<double>(totalAllocations) / commandCount,
+            percentile(50), percentile(99)};
+}
+
+/**
+ * Compares the savings of the exact deal solver to applying each deal greedily for every cluster of
+ * every cart.
+ * @param catalog The catalog of overlapping deals.
+ * @param carts The carts.
+ * @returns The comparison.
+*/
+SolverComparison compareDealSolvers(const Catalog& catalog, const std::vector<std::vector<CartLine>>& carts) {
+    SolverComparison comparison;
+    DealSolver exact;
+    DealSolver greedy(0);
+    std::vector<int> quantities(catalog.getItemCount());
+    std::vector<int> clusterQuantities;
+
+    for (const std::vector<CartLine>& cart : carts) {
+        // Total the units of each item, and find the clusters of the cart
+        std::fill(quantities.begin(), quantities.end(), 0);
+        std::vector<int> clusterIds;
+        for (const CartLine& line : cart) {
+            int itemId = catalog.getItemId(line.name);
+            quantities[itemId] += line.quantity;
+            clusterIds.push_back(catalog.getItem(itemId).dealClusterId);
+        }
+        std::sort(clusterIds.begin(), clusterIds.end());
+        clusterIds.erase(std::unique(clusterIds.begin(), clusterIds.end()), clusterIds.end());
+
+        for (int clusterId : clusterIds) {
+            if (clusterId == -1) {
+                continue;
+            }
+            DealCluster cluster = catalog.getDealCluster(clusterId);
+            clusterQuantities.clear();
+            for (int itemId : cluster.itemIds) {
+                clusterQuantities.push_back(quantities[itemId]);
+            }
+            long long greedySavings = greedy.solve(catalog, clusterId, clusterQuantities.data(), nullptr).savings.getCents();
+            const DealSolver::Result& result = exact.solve(catalog, clusterId, clusterQuantities.data(), nullptr);
+
+            comparison.clusters++;
+            comparison.optimalClusters += result.isOptimal;
+            comparison.improvedClusters += result.savings.getCents() > greedySavings;
+            comparison.greedySavings += greedySavings;
+            comparison.bestSavings += result.savings.getCents();
+            comparison.maxGap = std::max(comparison.maxGap, static_cast<long long>((result.upperBound - result.savings).getCents()));
+            comparison.maxNodes = std::max(comparison.maxNodes, result.nodes);
+        }
+    }
+    return comparison;
+}
+
+/**
+ * Prints the benchmark parameters and results as JSON.
+ * @param config The benchmark parameters.
+ * @param results The benchmark results.
+ * @param comparison The deal solver comparison, printed if it covers any clusters.
+ * @param journal The journal summary, printed if any events were journaled.
+ * @param layout The catalog layout summary, printed if the layouts were compared.
+ * @param out The output stream.
+*/
+void printJson(const BenchConfig& config, const std::vector<BenchResult>& results, const SolverComparison& comparison,
+               const JournalSummary& journal, const LayoutSummary& layout, std::ostream& out) {
+    char number[64];
+    auto fixed = [&number](double value) {
+        std::snprintf(number, sizeof(number), "%.2f", value);
+        return std::string(number);
+    };
+
+    out << "{\n";
+    out << "  \"config\": {\"items\": " << config.itemCount << ", \"deals\": " << config.dealCount
+        << ", \"deal_size\": " << config.dealSize << ", \"cart_lines\": " << config.cartLines
+        << ", \"quantity\": \"" << config.quantity << "\", \"max_quantity\": " << config.maxQuantity
+        << ", \"samples\": " << config.samples << ", \"load_samples\": " << config.loadSamples
+        << ", \"load_threads\": " << config.loadThreads
+        << ", \"seed\": " << config.seed << ", \"lanes\": " << config.lanes
+        << ", \"lane_carts\": " << config.laneCarts << ", \"overlap_clusters\": " << config.overlapClusters
+        << ", \"steady_carts\": " << config.steadyCarts << ", \"wide_cart_lines\": " << config.wideCartLines
+        << ", \"text_mib\": " << config.textMiB << ", \"journal_events\": " << config.journalEvents
+        << ", \"avx2\": " << (CpuFeatures::hasAvx2() ? "true" : "false") << "},\n";
+    if (comparison.clusters > 0) {
+        out << "  \"deal_solver\": {\"clusters\": " << comparison.clusters << ", \"optimal_clusters\": " << comparison.optimalClusters
+            << ", \"improved_clusters\": " << comparison.improvedClusters << ", \"greedy_savings_cents\": " << comparison.greedySavings
+            << ", \"best_savings_cents\": " << comparison.bestSavings << ", \"max_gap_cents\": " << comparison.maxGap
+            << ", \"max_nodes\": " << comparison.maxNodes << "},\n";
+    }
+    if (journal.events > 0) {
+        out << "  \"journal\": {\"events\": " << journal.events << ", \"bytes\": " << journal.bytes
+            << ", \"commits\": " << journal.commits << "},\n";
+    }
+    if (layout.items > 0) {
+        auto usage = [](const Catalog::MemoryUsage& usage) {
+            return "{\"names_bytes\": " + std::to_string(usage.names) + ", \"index_bytes\": " + std::to_string(usage.index)
+                + ", \"items_bytes\": " + std::to_string(usage.items) + ", \"deals_bytes\": " + std::to_string(usage.deals)
+                + ", \"total_bytes\": " + std::to_string(usage.total()) + "}";
+        };
+        out << "  \"catalog_layout\": {\"items\": " << layout.items << ", \"deals\": " << layout.deals
+            << ", \"columns\": " << usage(layout.columns) << ", \"legacy\": " << usage(layout.legacy)
+            << ", \"legacy_allocations\": " << layout.legacyAllocations << "},\n";
+    }
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        out << "    {\"name\": \"" << result.name << "\", \"ops\": " << result.ops
+            << ", \"ops_per_sec\": " << fixed(result.nsPerOp > 0 ? 1e9 / result.nsPerOp : 0)
+            << ", \"ns_per_op\": " << fixed(result.nsPerOp) << ", \"allocs_per_op\": " << fixed(result.allocsPerOp)
+            << ", \"p50_ns\": " << fixed(result.p50) << ", \"p99_ns\": " << fixed(result.p99) << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    try {
+        config = parseArguments(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+    SolverComparison comparison;
+    JournalSummary journalSummary;
+    LayoutSummary layoutSummary;
+    long long steadyStateAllocations = 0;
+    auto enabled = [&config](const std::string& name) {
+        return name.find(config.filter) != std::string::npos;
+    };
+    auto noSetup = []() {};
+
+    try {
+        // Write the synthetic catalog to a scratch directory
+        std::filesystem::path dir = std::filesystem::temp_directory_path() / "supermarket_bench";
+        std::filesystem::create_directories(dir);
+        std::string itemsPath = (dir / "items.csv").string();
+        std::string dealsPath = (dir / "deals.csv").string();
+        std::string overlapDealsPath = (dir / "overlap_deals.csv").string();
+
+        if (enabled("generateCatalog")) {
+            results.push_back(measure("generateCatalog", config.loadSamples, 1, noSetup, [&](int) {
+                generateCatalog(config, itemsPath, dealsPath, overlapDealsPath);
+            }));
+        } else {
+            generateCatalog(config, itemsPath, dealsPath, overlapDealsPath);
+        }
+
+        // Load the catalog, discarding the previous one before each sample
+        std::shared_ptr<Catalog> catalog;
+        if (enabled("readItemsFromFile")) {
+            results.push_back(measure("readItemsFromFile", config.loadSamples, 1, [&]() {
+                catalog.reset(new Catalog());
+                catalog->setLoadThreadCount(config.loadThreads);
+            }, [&](int) {
+                catalog->readItemsFromFile(itemsPath);
+            }));
+        }
+        if (enabled("readDealsFromFile")) {
+            results.push_back(measure("readDealsFromFile", config.loadSamples, 1, [&]() {
+                catalog.reset(new Catalog());
+                catalog->setLoadThreadCount(config.loadThreads);
+                catalog->readItemsFromFile(itemsPath);
+            }, [&](int) {
+                catalog->readDealsFromFile(dealsPath);
+            }));
+        }
+        catalog.reset(new Catalog());
+        catalog->setLoadThreadCount(config.loadThreads);
+        catalog->readItemsFromFile(itemsPath);
+        catalog->readDealsFromFile(dealsPath);
+
+        // Draw lookups and carts
+        std::mt19937_64 rng(config.seed);
+        std::vector<std::vector<CartLine>> carts;
+        for (int i = 0; i < config.samples; i++) {
+            carts.push_back(generateCart(config, rng, config.itemCount));
+        }
+        const int lookupsPerSample = 1024;
+        std::vector<std::string> lookups;
+        std::uniform_int_distribution<int> items(0, config.itemCount - 1);
+        for (int i = 0; i < lookupsPerSample; i++) {
+            lookups.push_back(itemName(items(rng)));
+        }
+
+        CheckoutRegister reg(*catalog);
+        NullBuffer nullBuffer;
+        std::ostream nullStream(&nullBuffer);
+        int sample = 0;
+        int found = 0;
+
+        // Scans a whole cart into the register
+        auto scanCart = [&](const std::vector<CartLine>& cart) {
+            for (const CartLine& line : cart) {
+                reg.scanItem(line.name, line.quantity);
+            }
+        };
+
+        // Warm up the register so that container growth is not measured
+        for (const std::vector<CartLine>& cart : carts) {
+            scanCart(cart);
+            reg.checkOut(nullStream);
+        }
+
+        if (enabled("getItemId")) {
+            results.push_back(measure("getItemId", config.samples, lookupsPerSample, noSetup, [&](int i) {
+                found += catalog->getItemId(lookups[i]) != -1;
+            }));
+        }
+        if (enabled("scanItem")) {
+            sample = 0;
+            results.push_back(measure("scanItem", config.samples, config.cartLines, [&]() {
+                reg.clearSession();
+                sample++;
+            }, [&](int i) {
+                const CartLine& line = carts[sample - 1][i];
+                reg.scanItem(line.name, line.quantity);
+            }));
+        }
+        if (enabled("scanBatch")) {
+            // Scan each whole cart as a single batch of names
+            std::vector<std::vector<ScanEntry>> batches;
+            for (const std::vector<CartLine>& cart : carts) {
+                batches.emplace_back();
+                for (const CartLine& line : cart) {
+                    batches.back().push_back({line.name, -1, line.quantity});
+                }
+            }
+            std::vector<ScanStatus> statuses(config.cartLines);
+            for (const std::vector<ScanEntry>& batch : batches) {
+                reg.scanBatch(batch.data(), batch.size(), statuses.data());
+                reg.clearSession();
+            }
+            sample = 0;
+            results.push_back(measure("scanBatch", config.samples, 1, [&]() {
+                reg.clearSession();
+                sample++;
+            }, [&](int) {
+                const std::vector<ScanEntry>& batch = batches[sample - 1];
+                found += reg.scanBatch(batch.data(), batch.size(), statuses.data()) == 0;
+            }));
+        }
+        if (enabled("rejectedScan")) {
+            // Reject scans of unknown items and invalid quantities, through exceptions and through statuses
+            std::vector<std::string> unknownNames;
+            for (const std::string& name : lookups) {
+                unknownNames.push_back(name + " (unknown)");
+            }
+            auto rejectedScan = [&](int i) {
+                return i % 2 == 0 ? ScanEntry{unknownNames[i], -1, 1} : ScanEntry{lookups[i], -1, 0};
+            };
+            results.push_back(measure("rejectedScanItem", config.samples, lookupsPerSample, noSetup, [&](int i) {
+                ScanEntry entry = rejectedScan(i);
+                try {
+                    reg.scanItem(entry.itemName, entry.quantity);
+                } catch (const std::runtime_error& e) {
+                    found++;
+                }
+            }));
+            results.push_back(measure("rejectedTryScanItem", config.samples, lookupsPerSample, noSetup, [&](int i) {
+                ScanEntry entry = rejectedScan(i);
+                found += reg.tryScanItem(entry.itemName, entry.quantity) != ScanStatus::Ok;
+            }));
+            reg.clearSession();
+        }
+        if (enabled("calculateDeals")) {
+            sample = 0;
+            results.push_back(measure("calculateDeals", config.samples, 1, [&]() {
+                reg.clearSession();
+                scanCart(carts[sample++]);
+            }, [&](int) {
+                RegisterBenchmark::calculateDeals(reg);
+            }));
+        }
+        if (enabled("printReceipt")) {
+            sample = 0;
+            results.push_back(measure("printReceipt", config.samples, 1, [&]() {
+                reg.clearSession();
+                scanCart(carts[sample++]);
+                RegisterBenchmark::calculateDeals(reg);
+            }, [&](int) {
+                RegisterBenchmark::printReceipt(reg, nullStream);
+            }));
+        }
+        if (enabled("checkOut")) {
+            sample = 0;
+            reg.clearSession();
+            results.push_back(measure("checkOut", config.samples, 1, noSetup, [&](int) {
+                scanCart(carts[sample++]);
+                reg.checkOut(nullStream);
+            }));
+        }
+        if (enabled("steadyStateCheckOut")) {
+            // Check out many consecutive carts on the warmed up register, which must not allocate
+            reg.clearSession();
+            BenchResult result = measure("steadyStateCheckOut", config.steadyCarts, 1, noSetup, [&](int) {
+                scanCart(carts[sample++ % carts.size()]);
+                reg.checkOut(nullStream);
+            });
+            steadyStateAllocations = std::llround(result.allocsPerOp * result.ops);
+            results.push_back(result);
+        }
+        if (enabled("priceLines")) {
+            // Price a wholesale cart with every kernel the processor supports, which must agree exactly
+            std::vector<std::int64_t> wideUnitPrices(config.wideCartLines);
+            std::vector<int> wideQuantities(config.wideCartLines);
+            std::uniform_int_distribution<int> quantities(0, config.maxQuantity);
+            for (int i = 0; i < config.wideCartLines; i++) {
+                wideUnitPrices[i] = catalog->getItemPrices()[items(rng)];
+                wideQuantities[i] = quantities(rng);
+            }
+            std::vector<std::int64_t> scalarPrices(config.wideCartLines);
+            std::vector<std::int64_t> kernelPrices(config.wideCartLines);
+            std::int64_t scalarTotal = PricingKernel::priceLinesScalar(wideUnitPrices.data(), wideQuantities.data(),
+                config.wideCartLines, scalarPrices.data());
+
+            std::vector<std::pair<std::string, decltype(&PricingKernel::priceLines)>> kernels = {
+                {"priceLinesScalar", &PricingKernel::priceLinesScalar}};
+            if (CpuFeatures::hasAvx2()) {
+                kernels.emplace_back("priceLinesAvx2", &PricingKernel::priceLinesAvx2);
+            }
+            for (const auto& kernel : kernels) {
+                if (!enabled(kernel.first)) {
+                    continue;
+                }
+                std::int64_t total = 0;
+                results.push_back(measure(kernel.first, config.samples, 1, noSetup, [&](int) {
+                    total = kernel.second(wideUnitPrices.data(), wideQuantities.data(), config.wideCartLines,
+                                          kernelPrices.data());
+                }));
+                if (total != scalarTotal || kernelPrices != scalarPrices) {
+                    throw std::runtime_error(kernel.first + " does not match the scalar kernel.");
+                }
+            }
+        }
+        if (enabled("camelCaseText")) {
+            // Split the names from catalog lines and convert them to Camel Case, which must agree exactly.
+            // The lines are generated once and converted repeatedly, so each sample is one pass over them.
+            const size_t textBytes = std::min<size_t>(config.textMiB, 64) << 20;
+            std::vector<std::string> slices = generateCatalogText(rng, textBytes);
+            int passes = (config.textMiB + 63) / 64;
+            std::string itemName;
+            auto camelCaseSlice = [&itemName](const std::string& slice, decltype(&IOHelper::toCamelCase) toCamelCase,
+                                              std::vector<std::string>* names) {
+                std::string_view line, field;
+                size_t pos = 0;
+                while (IOHelper::nextField(slice, pos, '\n', line)) {
+                    size_t fieldPos = 0;
+                    IOHelper::nextField(line, fieldPos, ',', field);
+                    itemName.assign(field);
+                    toCamelCase(itemName);
+                    if (names) {
+                        names->push_back(itemName);
+                    }
+                }
+            };
+
+            std::vector<std::string> scalarNames;
+            std::vector<std::string> kernelNames;
+            camelCaseSlice(slices[0], &IOHelper::toCamelCaseScalar, &scalarNames);
+            camelCaseSlice(slices[0], &IOHelper::toCamelCase, &kernelNames);
+            if (scalarNames != kernelNames) {
+                throw std::runtime_error("toCamelCase does not match toCamelCaseScalar.");
+            }
+
+            // Each operation converts one slice of about 1 MiB, so operations per second are MiB per second
+            std::vector<std::pair<std::string, decltype(&IOHelper::toCamelCase)>> conversions = {
+                {"camelCaseTextScalar", &IOHelper::toCamelCaseScalar}, {"camelCaseText", &IOHelper::toCamelCase}};
+            for (const auto& conversion : conversions) {
+                if (!enabled(conversion.first)) {
+                    continue;
+                }
+                results.push_back(measure(conversion.first, passes, slices.size(), noSetup, [&](int i) {
+                    camelCaseSlice(slices[i], conversion.second, nullptr);
+                }));
+            }
+        }
+        if (enabled("OverlappingDeals")) {
+            // Load the overlapping deals over the same items, and draw carts from the items of their clusters
+            auto overlapCatalog = std::make_shared<Catalog>();
+            overlapCatalog->readItemsFromFile(itemsPath);
+            overlapCatalog->readDealsFromFile(overlapDealsPath);
+            std::vector<std::vector<CartLine>> overlapCarts;
+            for (int i = 0; i < config.samples; i++) {
+                overlapCarts.push_back(generateCart(config, rng, config.overlapClusters * overlapClusterSize));
+            }
+            comparison = compareDealSolvers(*overlapCatalog, overlapCarts);
+
+            // Time the exact solver against applying each deal greedily
+            for (bool isGreedy : {false, true}) {
+                std::string name = isGreedy ? "calculateOverlappingDealsGreedy" : "calculateOverlappingDeals";
+                if (!enabled(name)) {
+                    continue;
+                }
+                CheckoutRegister overlapReg(*overlapCatalog);
+                RegisterBenchmark::setDealNodeBudget(overlapReg, isGreedy ? 0 : DealSolver::defaultNodeBudget);
+                for (const std::vector<CartLine>& cart : overlapCarts) {
+                    for (const CartLine& line : cart) {
+                        overlapReg.scanItem(line.name, line.quantity);
+                    }
+                    overlapReg.checkOut(nullStream);
+                }
+                sample = 0;
+                results.push_back(measure(name, config.samples, 1, [&]() {
+                    overlapReg.clearSession();
+                    for (const CartLine& line : overlapCarts[sample++]) {
+                        overlapReg.scanItem(line.name, line.quantity);
+                    }
+                }, [&](int) {
+                    RegisterBenchmark::calculateDeals(overlapReg);
+                }));
+            }
+        }
+        if (enabled("walkDeals")) {
+            // Copy the catalog into the legacy layout, counting the allocations it needs
+            size_t allocationsBefore = allocations();
+            LegacyCatalog legacy = buildLegacyCatalog(*catalog);
+            layoutSummary.items = catalog->getItemCount();
+            layoutSummary.deals = catalog->getDealCount();
+            layoutSummary.legacyAllocations = allocations() - allocationsBefore;
+            layoutSummary.columns = catalog->getMemoryUsage();
+            layoutSummary.legacy = legacyMemoryUsage(legacy, layoutSummary.columns);
+
+            // Price one group of every deal at regular prices, which must agree exactly. Each
+            // operation walks every deal.
+            std::int64_t columnTotal = 0;
+            std::int64_t legacyTotal = 0;
+            results.push_back(measure("walkDeals", config.loadSamples, 1, noSetup, [&](int) {
+                const std::int64_t* prices = catalog->getItemPrices();
+                std::int64_t total = 0;
+                for (int dealId = 0; dealId < catalog->getDealCount(); dealId++) {
+                    Deal deal = catalog->getDeal(dealId);
+                    for (size_t i = 0; i < deal.itemIds.size(); i++) {
+                        total += prices[deal.itemIds[i]] * deal.itemCounts[i];
+                    }
+                }
+                columnTotal = total;
+            }));
+            results.push_back(measure("walkDealsLegacy", config.loadSamples, 1, noSetup, [&](int) {
+                std::int64_t total = 0;
+                for (const LegacyCatalog::Deal& deal : legacy.deals) {
+                    for (size_t i = 0; i < deal.itemIds.size(); i++) {
+                        total += legacy.items[deal.itemIds[i]].price.getCents() * (deal.itemCounts.empty() ? 1 : deal.itemCounts[i]);
+                    }
+                }
+                legacyTotal = total;
+            }));
+            if (columnTotal != legacyTotal) {
+                throw std::runtime_error("walkDeals does not match walkDealsLegacy.");
+            }
+        }
+        if (enabled("trackDealClusters")) {
+            // Collect the deal clusters of each cart's items in scan order, repeats included
+            std::vector<std::vector<int>> cartClusters;
+            for (const std::vector<CartLine>& cart : carts) {
+                cartClusters.emplace_back();
+                for (const CartLine& line : cart) {
+                    int clusterId = catalog->getItemDealClusterId(catalog->getItemId(line.name));
+                    if (clusterId != -1) {
+                        cartClusters.back().push_back(clusterId);
+                    }
+                }
+            }
+
+            // Add each cart's clusters, visit them in ascending id order and clear them, with the
+            // register's bitmap and with an ordered set. The visited ids must agree exactly.
+            IdBitmap bitmap;
+            bitmap.resize(catalog->getDealClusterCount());
+            std::int64_t bitmapTotal = 0;
+            std::int64_t setTotal = 0;
+            sample = 0;
+            results.push_back(measure("trackDealClusters", config.samples, 1, [&]() {
+                sample++;
+            }, [&](int) {
+                for (int clusterId : cartClusters[sample - 1]) {
+                    bitmap.insert(clusterId);
+                }
+                std::int64_t order = 0;
+                bitmap.forEach([&](int clusterId) {
+                    bitmapTotal += clusterId * ++order;
+                });
+                bitmap.clear();
+            }));
+            sample = 0;
+            results.push_back(measure("trackDealClustersSet", config.samples, 1, [&]() {
+                sample++;
+            }, [&](int) {
+                std::set<int> clusters(cartClusters[sample - 1].begin(), cartClusters[sample - 1].end());
+                std::int64_t order = 0;
+                for (int clusterId : clusters) {
+                    setTotal += clusterId * ++order;
+                }
+            }));
+            if (bitmapTotal != setTotal) {
+                throw std::runtime_error("trackDealClusters does not match trackDealClustersSet.");
+            }
+        }
+        if (enabled("Journal")) {
+            // Draw events of every lane, ending about one cart in cartLines with a checkout
+            std::vector<JournalEvent> events(config.journalEvents);
+            std::vector<std::string> eventNames(config.journalEvents);
+            std::uniform_int_distribution<int> lanes(0, config.lanes - 1);
+            std::uniform_int_distribution<int> quantities(1, config.maxQuantity);
+            std::uniform_int_distribution<int> checkouts(0, config.cartLines - 1);
+            for (int i = 0; i < config.journalEvents; i++) {
+                JournalEvent& event = events[i];
+                event.registerId = lanes(rng);
+                event.type = checkouts(rng) == 0 ? JournalEventType::Checkout : JournalEventType::Scan;
+                event.quantity = 0;
+                if (event.type == JournalEventType::Scan) {
+                    eventNames[i] = itemName(items(rng));
+                    event.itemName = eventNames[i];
+                    event.quantity = quantities(rng);
+                }
+            }
+
+            // Append every event from one thread, and wait for the last one to be durable
+            std::string journalPath = (dir / "journal.wal").string();
+            std::unique_ptr<Journal> journal;
+            BenchResult appendResult = measure("appendJournal", config.loadSamples, config.journalEvents, [&]() {
+                journal.reset();
+                journal.reset(new Journal(journalPath));
+            }, [&](int i) {
+                const JournalEvent& event = events[i];
+                std::uint64_t sequence = journal->append(event.type, event.registerId, event.itemName, event.quantity);
+                if (i + 1 == config.journalEvents) {
+                    journal->waitUntilDurable(sequence);
+                }
+            });
+            journal->publish();
+            journalSummary = {config.journalEvents, static_cast<long long>(std::filesystem::file_size(journalPath)),
+                              static_cast<long long>(journal->getCommitCount())};
+            journal.reset();
+            if (enabled("appendJournal")) {
+                results.push_back(appendResult);
+            }
+
+            // Recover the open carts of every lane from a fresh copy of the log
+            if (enabled("recoverJournal")) {
+                std::string logPath = (dir / "journal.log").string();
+                std::filesystem::copy_file(journalPath, logPath, std::filesystem::copy_options::overwrite_existing);
+                std::vector<std::unique_ptr<CheckoutRegister>> laneRegisters;
+                std::vector<CheckoutRegister*> registers;
+                results.push_back(measure("recoverJournal", config.loadSamples, 1, [&]() {
+                    journal.reset();
+                    std::filesystem::copy_file(logPath, journalPath, std::filesystem::copy_options::overwrite_existing);
+                    laneRegisters.clear();
+                    registers.clear();
+                    for (int lane = 0; lane < config.lanes; lane++) {
+                        laneRegisters.emplace_back(new CheckoutRegister(*catalog));
+                        registers.push_back(laneRegisters.back().get());
+                    }
+                }, [&](int) {
+                    journal = CheckoutRegister::recoverJournal(journalPath, registers);
+                }));
+                laneRegisters.clear();
+                journal.reset();
+            }
+        }
+        if (enabled("storeCommands")) {
+            results.push_back(runStoreLoad(config, catalog, rng, nullStream));
+        }
+
+        // Keep lookups from being optimized away
+        if (found < 0) {
+            std::cerr << found << std::endl;
+        }
+        std::filesystem::remove_all(dir);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    printJson(config, results, comparison, journalSummary, layoutSummary, std::cout);
+    if (steadyStateAllocations > 0) {
+        std::cerr << "Checking out " << config.steadyCarts << " consecutive carts made " << steadyStateAllocations
+                  << " heap allocations, but a warmed up register should make none." << std::endl;
+        return 1;
+    }
+    return 0;
+}
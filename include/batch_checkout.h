@@ -0,0 +1,104 @@
+#ifndef BATCH_CHECKOUT_H
+#define BATCH_CHECKOUT_H
+
+#include "catalog.h"
+#include "receipt_sink.h"
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <utility>
+
+/**
+ * Prices many customer carts in a single run.
+ * Carts are sharded over a pool of worker threads, each of which checks out its carts through
+ * its own CheckoutRegister against the shared, read-only catalog.
+*/
+class BatchCheckout {
+    private:
+        /**
+         * A single customer cart read from a batch input file.
+        */
+        struct Cart {
+            /**
+             * The cart id.
+            */
+            int id;
+
+            /**
+             * The scanned lines of the cart in input order, as item name and quantity pairs.
+            */
+            std::vector<std::pair<std::string, int>> lines;
+
+            /**
+             * The printed receipt for the cart, set once the cart has been checked out.
+            */
+            std::string receipt;
+
+            /**
+             * Describes why the cart could not be checked out. Empty if the cart is valid.
+            */
+            std::string error;
+        };
+
+        /**
+         * Reference to the catalog.
+        */
+        const Catalog& catalog;
+
+        /**
+         * The number of worker threads used to check out carts.
+        */
+        unsigned int threadCount;
+
+        /**
+         * The format of the receipts.
+        */
+        ReceiptFormat format;
+
+        /**
+         * All carts in the batch, ordered by cart id.
+        */
+        std::vector<Cart> carts;
+
+        /**
+         * Repeatedly claims chunks of unprocessed carts and checks them out
+         * through a register owned by the calling thread.
+         * @param nextCart The index of the next unclaimed cart, shared by all workers.
+        */
+        void checkOutCarts(std::atomic<size_t>& nextCart);
+
+    public:
+        /**
+         * Instantiates a batch checkout.
+         * @param catalog The catalog for the registers to reference items and deals.
+         * @param threadCount The number of worker threads to use. If 0, one thread is used
+         * per available hardware thread.
+         * @param format The format of the receipts.
+        */
+        BatchCheckout(const Catalog& catalog, unsigned int threadCount = 0, ReceiptFormat format = ReceiptFormat::Text);
+
+        /**
+         * Reads carts from a csv file with lines in the format `cartId,itemName,quantity`.
+         * Lines of the same cart do not need to be adjacent.
+         * @param filepath The path to the file.
+        */
+        void readCartsFromFile(const std::string& filepath);
+
+        /**
+         * Checks out all carts in the batch in parallel.
+        */
+        void checkOut();
+
+        /**
+         * Prints the receipts of all carts in order of cart id to an output stream. Text receipts are
+         * each preceded by a line with their cart id, while other formats record the cart id in the receipt.
+         * Carts that could not be checked out are reported to the standard error instead.
+         * @param out The output stream.
+         * @returns The number of carts that could not be checked out.
+        */
+        int printReceipts(std::ostream& out = std::cout) const;
+};
+
+#endif
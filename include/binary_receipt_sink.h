@@ -0,0 +1,61 @@
+#ifndef BINARY_RECEIPT_SINK_H
+#define BINARY_RECEIPT_SINK_H
+
+#include "receipt_sink.h"
+
+#include <string>
+
+/**
+ * Writes receipts as compact binary records. All integers are little endian.
+ *
+ * Record:
+ *   u32 length of the rest of the record in bytes
+ *   u8  record version (2)
+ *   i32 cart id, -1 if none
+ *   i64 checkout time in seconds since the epoch
+ *   i64 savings in cents
+ *   i64 total in cents
+ *   u32 number of deal groups, followed by the deal groups
+ *   u32 number of deal lines, followed by the deal lines
+ *   u32 number of remaining item lines, followed by the item lines
+ *
+ * Deal group:
+ *   i64 price paid for the group in cents
+ *   i64 savings of the group in cents
+ *   u8  1 if the group is a bundle, else 0
+ *
+ * Line:
+ *   u16 name length, followed by the name bytes
+ *   i32 quantity
+ *   i64 price in cents
+ *   i32 deal group index, -1 for remaining items
+ *   u8  1 if the line is free, else 0
+*/
+class BinaryReceiptSink : public ReceiptSink {
+    private:
+        /**
+         * The output stream.
+        */
+        std::ostream& out;
+
+        /**
+         * Encodes each record, reused so it is only allocated once.
+        */
+        std::string buffer;
+
+    public:
+        /**
+         * The version written to every record.
+        */
+        static const unsigned char recordVersion = 2;
+
+        /**
+         * Instantiates a sink.
+         * @param out The output stream, which must outlive the sink and be opened in binary mode.
+        */
+        explicit BinaryReceiptSink(std::ostream& out);
+
+        void write(const Receipt& receipt) override;
+};
+
+#endif
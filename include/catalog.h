@@ -2,78 +2,363 @@
 #define CATALOG_H
 
 #include "catalog_item.h"
+#include "deal.h"
+#include "mapped_file.h"
 
-#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
 #include <unordered_set>
 #include <vector>
 #include <string>
+#include <string_view>
 
 /**
  * The Supermarket items catalog which stores item prices and deals.
 */
 class Catalog {
+    public:
+        /**
+         * Statistics about reading a single catalog file.
+        */
+        struct LoadStats {
+            /**
+             * The path to the file.
+            */
+            std::string filepath;
+
+            /**
+             * The size of the file in bytes.
+            */
+            size_t bytes;
+
+            /**
+             * The time taken to read the file and add its contents to the catalog, in seconds.
+            */
+            double seconds;
+        };
+
+        /**
+         * The memory used by the parts of a catalog, in bytes.
+        */
+        struct MemoryUsage {
+            /**
+             * The item names, stored or read in place from a mapped snapshot file.
+            */
+            size_t names;
+
+            /**
+             * The item index.
+            */
+            size_t index;
+
+            /**
+             * The item columns other than the names themselves.
+            */
+            size_t items;
+
+            /**
+             * The deal and deal cluster columns.
+            */
+            size_t deals;
+
+            /**
+             * Gets the memory used by the whole catalog.
+             * @returns The size in bytes.
+            */
+            size_t total() const {
+                return names + index + items + deals;
+            }
+        };
+
     private:
         /**
-         * Maps item name strings to their item id.
-         * An item's id is its index into the items vector.
+         * A slot of the item index.
+        */
+        struct IndexSlot {
+            /**
+             * The upper 32 bits of the hash of the item's name, compared before the name itself
+             * so that probing rarely touches the names of other items.
+            */
+            std::uint32_t tag;
+
+            /**
+             * The item id, or -1 if the slot is empty.
+            */
+            std::int32_t itemId;
+        };
+
+        /**
+         * Open addressing hash table mapping item names to their item id, where an item's id is its
+         * index into the item columns. The capacity is a power of 2 and the table is kept at most
+         * half full, so linear probing stays short. The table only stores hash tags and ids, so it
+         * can be written to and read from snapshots as is.
         */
-        std::unordered_map<std::string, int> itemIdMap;
+        std::vector<IndexSlot> itemIndex;
 
         /**
-         * Vector of all items in the Supermarket. Items are indexed using their item id.
+         * The names of items read from csv files, concatenated in item id order.
         */
-        std::vector<CatalogItem> items;
+        std::vector<char> nameStorage;
 
         /**
-         * Vector of item deals. The deals are represented as vectors of the item id's in the deal, 
-         * ordered highest to lowest by price. The deals are indexed using their deal id.
+         * All item names, concatenated in item id order. Points into nameStorage, or into the
+         * mapped snapshot file the catalog was loaded from.
         */
-        std::vector<std::vector<int>> deals;
+        const char* namePool;
+
+        /**
+         * The mapped snapshot file the catalog was loaded from, if any. Kept open for the lifetime
+         * of the catalog since item names are read from it in place.
+        */
+        std::unique_ptr<MappedFile> snapshotFile;
+
+        /**
+         * The offset of every item's name in the name pool, as item count + 1 offsets, so the name
+         * of item id ends where the name of the next item starts.
+        */
+        std::vector<std::uint64_t> nameOffsets;
+
+        /**
+         * The price in cents of every item, indexed by item id, so pricing kernels can gather
+         * prices from a single column.
+        */
+        std::vector<std::int64_t> itemPrices;
+
+        /**
+         * The deal cluster id of every item, indexed by item id, or -1 if no deals apply to it.
+        */
+        std::vector<int> itemDealClusterIds;
+
+        /**
+         * The terms of every deal, indexed by deal id.
+        */
+        std::vector<DealTerms> dealTerms;
+
+        /**
+         * The offset of every deal's items in the deal item columns, as deal count + 1 offsets.
+         * The deals' items are stored back to back in one column (compressed sparse rows), so
+         * walking a deal reads consecutive memory rather than a separate allocation per deal.
+        */
+        std::vector<std::uint64_t> dealOffsets;
+
+        /**
+         * The item ids of every deal, each deal ordered highest to lowest by price.
+        */
+        std::vector<int> dealItemIds;
+
+        /**
+         * The number of units of each deal item in a group, parallel to dealItemIds.
+        */
+        std::vector<int> dealItemCounts;
+
+        /**
+         * The position of each deal item within its cluster's items, parallel to dealItemIds but
+         * with each deal's slots in ascending order.
+        */
+        std::vector<int> dealSlots;
+
+        /**
+         * The number of units of each deal slot in a group, parallel to dealSlots.
+        */
+        std::vector<int> dealSlotCounts;
+
+        /**
+         * The offset of every deal cluster's deals in clusterDealIds, as cluster count + 1 offsets.
+         * Clusters are indexed using their cluster id, which is stored on each of their items.
+        */
+        std::vector<std::uint64_t> clusterDealOffsets;
+
+        /**
+         * The deal ids of every cluster, in the order the deals were added to the catalog.
+        */
+        std::vector<int> clusterDealIds;
+
+        /**
+         * The offset of every deal cluster's items in clusterItemIds, as cluster count + 1 offsets.
+        */
+        std::vector<std::uint64_t> clusterItemOffsets;
+
+        /**
+         * The item ids of every cluster, each cluster ordered highest to lowest by price.
+        */
+        std::vector<int> clusterItemIds;
 
         /**
          * A set of keywords that cannot be used as item names because they are used as commands
          * for reading user input.
         */
-        static const std::unordered_set<std::string> reservedNames;
+        static const std::unordered_set<std::string_view> reservedNames;
 
         /**
-         * Adds an item to the catalog.
-         * @param name The item name.
+         * Statistics about each file read into the catalog, in the order they were read.
+        */
+        std::vector<LoadStats> loadStats;
+
+        /**
+         * The number of threads used to read each csv file, or 0 to use one per core.
+        */
+        unsigned int loadThreadCount;
+
+        /**
+         * Adds an item to the catalog, whose name has already been appended to the name pool.
+         * @param nameEnd The offset in the name pool of the end of the item name, which must not be reserved.
          * @param price The item price in USD.
+         * @param hash The hash of the item name.
+        */
+        void addItem(std::uint64_t nameEnd, Money price, std::uint64_t hash);
+
+        /**
+         * Gets the name of an item without checking its id.
+         * @param itemId The item id.
+         * @returns The item name.
+        */
+        std::string_view itemName(int itemId) const {
+            return std::string_view(namePool + nameOffsets[itemId], nameOffsets[itemId + 1] - nameOffsets[itemId]);
+        }
+
+        /**
+         * Hashes an item name for the item index. The hash is part of the snapshot format,
+         * so it must not change without changing the snapshot version.
+         * @param name The item name.
+         * @returns The hash.
+        */
+        static std::uint64_t hashName(std::string_view name);
+
+        /**
+         * Finds the item index slot holding an item name, or the empty slot where it would be inserted.
+         * @param name The item name.
+         * @param hash The hash of the item name.
+         * @returns The slot index.
+        */
+        size_t findIndexSlot(std::string_view name, std::uint64_t hash) const;
+
+        /**
+         * Rebuilds the item index with room for at least a number of items.
+         * @param itemCount The number of items to make room for.
         */
-        void addItem(const std::string& name, double price);
+        void reserveIndex(size_t itemCount);
 
         /**
-         * Adds a deal for a set of one or more items to the catalog.
-         * @param names A string of item names separated by commas. 
-         * Each item must already be present in the catalog, and must not be included in any 
-         * other deals for the deal to add succesfully.
+         * Reads a deal for a set of one or more items. Only reads the catalog, so deals can be read
+         * by several threads at once.
+         * @param line A string of item names separated by commas, optionally preceded by the deal
+         * terms and a colon, e.g. `Buy 3 Get 1: Chips,Crackers` or `Bundle 5.00: Bread,Butter,Jam`.
+         * Deals without terms are Buy 2 Get 1. Each item must already be present in the catalog,
+         * and may be included in any number of other deals.
+         * @param terms Set to the deal terms.
+         * @param itemIds Set to the ids of the deal's items, ordered highest to lowest by price.
+         * @param itemCounts Set to the number of units of each item in a group, parallel to itemIds.
         */
-        void addDeal(const std::string& itemNames);
+        void parseDeal(std::string_view line, DealTerms& terms, std::vector<int>& itemIds, std::vector<int>& itemCounts) const;
+
+        /**
+         * Groups the deals into clusters of deals connected through shared items, sets the cluster
+         * id of every item, and finds the slots of every deal's items within its cluster.
+        */
+        void buildDealClusters();
+
+        /**
+         * Records statistics about a file that was read successfully.
+         * @param filepath The path to the file.
+         * @param bytes The size of the file in bytes.
+         * @param start The time reading the file started.
+        */
+        void recordLoad(const std::string& filepath, size_t bytes, std::chrono::steady_clock::time_point start);
 
 
     public:
         /**
-         * Gets an item id using its name.
+         * Instantiates an empty catalog.
+        */
+        Catalog();
+
+        /**
+         * Gets an item id using its name. Does not allocate, so callers can look up views
+         * of their input directly.
          * @param itemName The item name.
-         * @returns The item id.
+         * @returns The item id, or -1 if no item has the name.
+        */
+        int getItemId(std::string_view itemName) const;
+
+        /**
+         * Gets the item ids of many names at once. The index slots of several names are fetched
+         * from memory together, which is faster than looking the names up one at a time.
+         * @param itemNames The item names.
+         * @param count The number of names.
+         * @param itemIds Set to the item id of each name, or -1 if no item has the name.
         */
-        int getItemId(const std::string& itemName) const;
+        void getItemIds(const std::string_view* itemNames, size_t count, int* itemIds) const;
 
         /**
-         * Gets an item object using its id
+         * Gets an item using its id, gathered from the item columns.
          * @param itemId The item id.
-         * @returns The item object.
+         * @returns The item.
+        */
+        CatalogItem getItem(int itemId) const;
+
+        /**
+         * Gets the deal cluster id of an item without reading its other columns.
+         * @param itemId The item id, which must be valid.
+         * @returns The cluster id, or -1 if no deals apply to the item.
         */
-        const CatalogItem& getItem(int itemId) const;
+        int getItemDealClusterId(int itemId) const {
+            return itemDealClusterIds[itemId];
+        }
 
         /**
-         * Gets a deal set based on the deal id.
+         * Gets the price column of the catalog.
+         * @returns The price in cents of every item, indexed by item id.
+        */
+        const std::int64_t* getItemPrices() const;
+
+        /**
+         * Gets a deal based on the deal id.
          * @param dealId The deal id.
-         * @returns A vector containing the ids of all the items in the deals, ordered highest
-         * to lowest by item price. 
+         * @returns The deal, with the ids of all its items ordered highest to lowest by item price.
+        */
+        Deal getDeal(int dealId) const;
+
+        /**
+         * Gets a deal cluster based on the cluster id.
+         * @param clusterId The cluster id.
+         * @returns The cluster.
+        */
+        DealCluster getDealCluster(int clusterId) const;
+
+        /**
+         * Gets the number of items in the catalog. Item ids range from 0 to this count - 1.
+         * @returns The number of items.
+        */
+        int getItemCount() const;
+
+        /**
+         * Gets the number of deals in the catalog. Deal ids range from 0 to this count - 1.
+         * @returns The number of deals.
+        */
+        int getDealCount() const;
+
+        /**
+         * Gets the number of deal clusters in the catalog. Cluster ids range from 0 to this count - 1.
+         * @returns The number of deal clusters.
+        */
+        int getDealClusterCount() const;
+
+        /**
+         * Gets the memory used by the catalog's columns and item index, including the names read in
+         * place from a mapped snapshot file.
+         * @returns The memory used by each part of the catalog.
+        */
+        MemoryUsage getMemoryUsage() const;
+
+        /**
+         * Sets the number of threads used to read each csv file. Large files are split into chunks
+         * of whole lines read in parallel, and the results are added in file order, so item ids,
+         * deal ids and errors do not depend on the number of threads.
+         * @param threadCount The number of threads, or 0 to use one per core.
         */
-        const std::vector<int>& getDeal(int dealId) const;
+        void setLoadThreadCount(unsigned int threadCount);
 
         /**
          * Reads items and prices from a csv file and adds them to the catalog.
@@ -88,14 +373,37 @@ class Catalog {
         void readDealsFromFile(const std::string& filepath);
 
         /**
-         * Prints catalog items to the standard output.
+         * Gets statistics about each file read into the catalog.
+         * @returns The statistics, in the order the files were read.
+        */
+        const std::vector<LoadStats>& getLoadStats() const;
+
+        /**
+         * Writes the catalog to a binary snapshot file, which can be loaded much faster than the
+         * csv files since items, sorted deals and the item index are stored ready to use.
+         * @param filepath The path to the file.
+        */
+        void saveSnapshot(const std::string& filepath) const;
+
+        /**
+         * Replaces the contents of the catalog with a binary snapshot file written by saveSnapshot.
+         * The snapshot's version and checksum are verified, but its items and deals are not
+         * validated again.
+         * @param filepath The path to the file.
+        */
+        void loadSnapshot(const std::string& filepath);
+
+        /**
+         * Prints catalog items to an output stream.
+         * @param out The output stream.
         */
-        void printItems() const;
+        void printItems(std::ostream& out = std::cout) const;
 
         /**
-         * Prints catalog deals to the standard output.
+         * Prints catalog deals to an output stream.
+         * @param out The output stream.
         */
-        void printDeals() const;
+        void printDeals(std::ostream& out = std::cout) const;
 };
 
 #endif
\ No newline at end of file
@@ -1,34 +1,30 @@
 #ifndef CATALOG_ITEM_H
 #define CATALOG_ITEM_H
 
-#include <string>
+#include "money.h"
+
+#include <string_view>
 
 /**
- * An item available for purchase in the Supermarket.
+ * An item available for purchase in the Supermarket. The catalog stores each field in its own
+ * column, and returns items by value.
 */
 struct CatalogItem {
     /**
-     * Item name.
+     * Item name. The name is stored by the catalog, and stays valid until more items are added.
     */
-    std::string name;
+    std::string_view name;
 
     /**
      * Item price in USD.
     */
-    double price;
+    Money price;
 
     /**
-     * The id of the deal that applies to this item.
+     * The id of the deal cluster containing every deal that applies to this item.
      * If no deals apply, this is set to -1.
     */
-    int dealId;
-
-    /**
-     * Instantiates a catalog item.
-     * @param name The item name.
-     * @param price The item price in USD.
-    */
-    CatalogItem(const std::string& name, double price);
+    int dealClusterId;
 };
 
-#endif
\ No newline at end of file
+#endif
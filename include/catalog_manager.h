@@ -0,0 +1,110 @@
+#ifndef CATALOG_MANAGER_H
+#define CATALOG_MANAGER_H
+
+#include "catalog.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * Publishes the current version of the catalog so it can be replaced while registers are running.
+ * Each version is immutable once published. Registers pin the current version with the first valid
+ * scan of each customer session and keep pricing against it until the session ends, so a reload never
+ * changes an in-flight cart. Registers move on to the newest version when a session ends, or at the
+ * next scan if they were idle during the reload, and a version is freed once no register holds it.
+*/
+class CatalogManager {
+    public:
+        /**
+         * Builds a new version of the catalog, throwing a std::runtime_error if it cannot.
+        */
+        using Loader = std::function<std::shared_ptr<const Catalog>()>;
+
+    private:
+        /**
+         * The current version. Only accessed through std::atomic_load and std::atomic_store.
+        */
+        std::shared_ptr<const Catalog> current;
+
+        /**
+         * The number of versions published, so registers can check for a new version without
+         * touching the shared pointer.
+        */
+        std::atomic<std::uint64_t> version;
+
+        /**
+         * Builds new versions for reloads.
+        */
+        Loader loader;
+
+        /**
+         * Serializes reloads, so versions are published in the order they were built.
+        */
+        std::mutex reloadMutex;
+
+        /**
+         * Guards reloadThread. The next background reload can start as soon as the last one clears
+         * isReloading, which may be before the caller that started the last one has stored its thread.
+        */
+        std::mutex threadMutex;
+
+        /**
+         * The thread of the last background reload.
+        */
+        std::thread reloadThread;
+
+        /**
+         * Whether a background reload is running.
+        */
+        std::atomic<bool> isReloading;
+
+    public:
+        /**
+         * Instantiates a manager.
+         * @param catalog The first version of the catalog.
+         * @param loader Builds new versions for reloads, or nullptr if the catalog can only be published.
+        */
+        CatalogManager(std::shared_ptr<const Catalog> catalog, Loader loader = nullptr);
+
+        /**
+         * Waits for any background reload to finish.
+        */
+        ~CatalogManager();
+
+        /**
+         * Gets the current version of the catalog.
+         * @returns The catalog, kept alive for as long as the pointer is held.
+        */
+        std::shared_ptr<const Catalog> acquire() const;
+
+        /**
+         * Gets the number of the current version, which increases with every publish.
+         * @returns The version number.
+        */
+        std::uint64_t getVersion() const;
+
+        /**
+         * Makes a catalog the current version. Sessions that are already open keep their version.
+         * @param catalog The catalog, which must not change after it is published.
+        */
+        void publish(std::shared_ptr<const Catalog> catalog);
+
+        /**
+         * Builds a new version with the loader and publishes it, keeping the current version if the
+         * loader fails.
+        */
+        void reload();
+
+        /**
+         * Starts reload() on a background thread, printing any error of the loader to the standard error.
+         * Throws a std::runtime_error if the manager has no loader.
+         * @returns Whether the reload was started, false if another one is still running.
+        */
+        bool reloadInBackground();
+};
+
+#endif
@@ -2,88 +2,348 @@
 #define CHECKOUT_REGISTER_H
 
 #include "catalog.h"
+#include "catalog_manager.h"
+#include "receipt_writer.h"
+#include "receipt_sink.h"
+#include "deal_solver.h"
+#include "scan_batch.h"
+#include "journal.h"
+#include "id_bitmap.h"
 
 #include <iostream>
-#include <unordered_map>
 #include <vector>
-#include <list>
 #include <string>
-#include <set>
+#include <string_view>
 #include <array>
+#include <cstdint>
+#include <memory>
 
 /**
  * A Supermaket register used to handle checkout. 
  * Scans user items in their cart, calculates maximum deals, and prints user receipts.
 */
 class CheckoutRegister {
+    /**
+     * The benchmark suite times the individual checkout stages.
+    */
+    friend class RegisterBenchmark;
+
     private:
         /**
-         * Reference to the catalog.
+         * The line of an item in the cart, only valid in the session it was written in.
+        */
+        struct ItemLine {
+            /**
+             * The session the line was written in.
+            */
+            std::uint32_t session;
+
+            /**
+             * The index of the item's line in cartIds, or -1 if the item is not in the cart.
+            */
+            std::int32_t line;
+        };
+
+        /**
+         * The manager publishing catalog versions, or nullptr if the register uses a fixed catalog.
+        */
+        const CatalogManager* catalogManager;
+
+        /**
+         * The catalog version pinned by the current session.
+        */
+        std::shared_ptr<const Catalog> catalog;
+
+        /**
+         * The number of the pinned catalog version.
+        */
+        std::uint64_t catalogVersion;
+
+        /**
+         * Whether a customer session has started since the cart was last cleared.
+        */
+        bool isSessionOpen;
+
+        /**
+         * The number of the current customer session. Per item state written in earlier sessions is
+         * treated as empty, so clearing a session does not have to visit it.
+        */
+        std::uint32_t session;
+
+        /**
+         * Ids of user scanned items, one per cart line in the order the items were first scanned.
+         * Lines of removed items stay in place with a quantity of 0 until the cart is compacted.
+        */
+        std::vector<int> cartIds;
+
+        /**
+         * Quantities of the cart lines, parallel to cartIds.
+        */
+        std::vector<int> cartQuantities;
+
+        /**
+         * Unit prices in cents of the cart lines, parallel to cartIds, copied from the catalog's price
+         * column when each line is added so cart lines can be priced without gathering.
+        */
+        std::vector<std::int64_t> cartUnitPrices;
+
+        /**
+         * The names of the entries of the batch being scanned that are looked up by name.
+        */
+        std::vector<std::string_view> batchNames;
+
+        /**
+         * The item ids of batchNames, or -1 for names not in the catalog.
+        */
+        std::vector<int> batchItemIds;
+
+        /**
+         * The ids of the deal clusters whose items were scanned by the batch being scanned.
+        */
+        IdBitmap batchClusters;
+
+        /**
+         * The price in cents of the remaining quantity of each cart line after calculateDeals(),
+         * parallel to cartIds.
+        */
+        std::vector<std::int64_t> linePrices;
+
+        /**
+         * Maps every item id in the catalog to its line in cartIds. Items without a line
+         * written in the current session are not in the cart.
+        */
+        std::vector<ItemLine> cartLineOfItem;
+
+        /**
+         * The number of lines in cartIds belonging to removed items.
+        */
+        int removedLines;
+
+        /**
+         * The ids of the deal clusters that may be applicable based on the scanned items, sized for
+         * every cluster of the catalog so adding and clearing them never allocates.
+        */
+        IdBitmap potentialClusters;
+
+        /**
+         * After calculateDeals() is called, stores a run-length description of the groups of
+         * items that form deals.
+        */
+        DealPlan dealPlan;
+
+        /**
+         * Finds the best deal groups of each deal cluster.
+        */
+        DealSolver dealSolver;
+
+        /**
+         * The cart quantities of the items of the deal cluster being solved, in the cluster's item order.
+        */
+        std::vector<int> clusterQuantities;
+
+        /**
+         * After calculateDeals() is called, stores the price paid for all items in deal groups.
+        */
+        Money dealsPrice;
+
+        /**
+         * After calculateDeals() is called, stores the total savings of all deal groups.
+        */
+        Money dealsSavings;
+
+        /**
+         * The full price of all items in the cart before savings, kept current while scanning.
+        */
+        Money cartPrice;
+
+        /**
+         * The maximum savings of each deal cluster in the catalog for the current cart, indexed by
+         * cluster id and kept current while scanning. Only valid for potential clusters.
+        */
+        std::vector<Money> savingsOfCluster;
+
+        /**
+         * The sum of savingsOfCluster, kept current while scanning.
+        */
+        Money cartSavings;
+
+        /**
+         * The receipt of the last checkout, reused so its lines are only allocated once.
         */
-        const Catalog& catalog;
+        Receipt receipt;
 
         /**
-         * List of ids of user scanned items.
+         * Formats receipts and carts, reused so its buffer is only allocated once.
         */
-        std::list<int> cartIds;
+        ReceiptWriter receiptWriter;
 
         /**
-         * Maps user scanned item id's to the desired quantity of that item.
+         * The journal the register's events are written to, or nullptr if they are not journaled.
         */
-        std::unordered_map<int, int> quantityOfCartItem;
-        
+        Journal* journal;
+
+        /**
+         * The id of the register in its journal.
+        */
+        std::uint32_t journalId;
+
+        /**
+         * Gets the line of an item in the cart.
+         * @param itemId The item id.
+         * @returns The index of the item's line in cartIds, or -1 if the item is not in the cart.
+        */
+        int lineOfItem(int itemId) const;
+
+        /**
+         * Sizes the per item and per deal cluster state for the pinned catalog, all of it empty.
+        */
+        void resetCatalogState();
+
         /**
-         * Stores a set of deal ids that may be applicable based on the scanned items.
+         * Finds the deal groups of a deal cluster giving the maximum savings for the current cart quantities.
+         * @param clusterId The cluster id.
+         * @param plan The plan to add the groups to, or nullptr if only the savings are needed.
+         * @returns The savings.
         */
-        std::set<int> potentialDeals;
+        Money solveCluster(int clusterId, DealPlan* plan);
 
         /**
-         * After calculateDeals() is called, stores groups of items that form deals,
-         * represented as arrays of the item ids.
+         * Adds a quantity of an item to its cart line, adding the line if the item is not in the cart
+         * yet. Does not update the running totals.
+         * @param itemId The item id.
+         * @param quantity The quantity, larger than 0.
         */
-        std::list<std::array<int,3>> dealGroups;
+        void addToCart(int itemId, int quantity);
+
+        /**
+         * Updates the running cart price and savings after the quantity of an item in the cart changes.
+         * @param itemId The item id.
+         * @param quantityChange The change in quantity of the item, negative for removals.
+        */
+        void updateRunningTotals(int itemId, int quantityChange);
 
         /**
          * Calculates which items should be grouped together to maximize customer savings,
-         * and stores these groups as arrays of item ids in dealGroups.
+         * stores these groups as runs of item ids in dealPlan, and removes the grouped
+         * items from the cart line quantities.
         */
         void calculateDeals();
 
+        /**
+         * Switches to the newest catalog version if the manager has published one. Must only be called
+         * while no session is open, as it resets the per item and per deal cluster state.
+        */
+        void refreshCatalog();
+
+        /**
+         * Ends the customer session, clearing all of its state without journaling it.
+        */
+        void endSession();
+
+        /**
+         * Journals the checkout of the open cart and waits until it is durable, if the register is journaled.
+        */
+        void commitCheckOut();
+
+        /**
+         * Removes the lines of removed items from the cart, preserving the order of the others.
+        */
+        void compactCart();
+
+        /**
+         * After calculateDeals() is called, fills the receipt with the deal groups, remaining items and totals.
+         * @param cartId The id of the cart, or -1 if it is not part of a batch.
+        */
+        void buildReceipt(int cartId);
+
         /**
          * Prints the receipt for the customer session to an output stream.
          * @param out the output stream.
         */
         void printReceipt(std::ostream& out);
 
+    public:
         /**
-         * Clears all state sepecific to a customer session.
+         * Instantiates a checkout register using a fixed catalog.
+         * @param catalog The catalog for the register to reference items and deals, which must outlive the register.
         */
-        void clearSession();
+        CheckoutRegister(const Catalog& catalog);
 
-    public:
         /**
-         * Instantiates a checkout register.
-         * @param catalog The catalog for the register to reference items and deals.
+         * Instantiates a checkout register that picks up new catalog versions at the start of each session.
+         * @param catalogManager The manager publishing catalog versions, which must outlive the register.
         */
-        CheckoutRegister(const Catalog& catalog);
+        CheckoutRegister(const CatalogManager& catalogManager);
 
         /**
          * Scans an item of some quantity into a user's cart.
          * @param itemName The name of the desired item.
          * @param quantity The desired item quantity.
         */
-        void scanItem(const std::string& itemName, int quantity);
+        void scanItem(std::string_view itemName, int quantity);
+
+        /**
+         * Scans an item of some quantity into a user's cart without throwing. Rejected scans are
+         * cheap, and their error message is only built if scanErrorMessage is called.
+         * @param itemName The name of the desired item.
+         * @param quantity The desired item quantity.
+         * @returns ScanStatus::Ok, or why nothing was scanned.
+        */
+        ScanStatus tryScanItem(std::string_view itemName, int quantity);
+
+        /**
+         * Scans a batch of items into a user's cart, with the same result as scanning each valid entry
+         * in turn with scanItem. Names are looked up together, repeated items are added to the same
+         * line, and the savings of each deal cluster are only recalculated once for the whole batch.
+         * Invalid entries are skipped and reported through their status instead of throwing.
+         * @param entries The entries.
+         * @param count The number of entries.
+         * @param statuses Set to the status of each entry, parallel to entries.
+         * @returns The number of entries that could not be scanned.
+        */
+        size_t scanBatch(const ScanEntry* entries, size_t count, ScanStatus* statuses);
+
+        /**
+         * Gets the error message scanItem or removeItem would throw for an entry that could not be
+         * scanned or removed.
+         * @param entry The entry.
+         * @param status The status of the entry, other than ScanStatus::Ok.
+         * @returns The message.
+        */
+        static std::string scanErrorMessage(const ScanEntry& entry, ScanStatus status);
 
         /**
          * Removes an item from a users cart.
          * @param itemName The name of the item.
         */
-        void removeItem(const std::string& itemName);
+        void removeItem(std::string_view itemName);
 
         /**
-         * Prints a users cart to the standard output
+         * Removes an item from a users cart without throwing.
+         * @param itemName The name of the item.
+         * @returns ScanStatus::Ok, or why nothing was removed.
         */
-        void printCart();
+        ScanStatus tryRemoveItem(std::string_view itemName);
+
+        /**
+         * Prints a users cart to an output stream.
+         * @param out The output stream.
+        */
+        void printCart(std::ostream& out = std::cout);
+
+        /**
+         * Gets the current total of the cart after savings. Kept current while items are
+         * scanned and removed, so this does not recalculate any deals.
+         * @returns The total in USD.
+        */
+        Money currentTotal() const;
+
+        /**
+         * Gets the current savings of the cart from deals. Kept current while items are
+         * scanned and removed, so this does not recalculate any deals.
+         * @returns The savings in USD.
+        */
+        Money currentSavings() const;
 
         /**
          * Calculates maximum deal groups, prints a user's receipt,
@@ -91,6 +351,57 @@ class CheckoutRegister {
          * @param receiptOutStream The output stream for the receipt to be printed to.
         */
         void checkOut(std::ostream& receiptOutStream = std::cout);
+
+        /**
+         * Calculates maximum deal groups, writes a user's receipt to a sink,
+         * and clears all cart state from the register.
+         * @param sink The sink for the receipt, in any format.
+         * @param cartId The id of the cart recorded on the receipt, or -1 if it is not part of a batch.
+        */
+        void checkOut(ReceiptSink& sink, int cartId = -1);
+
+        /**
+         * Gets the catalog version pinned by the current session.
+         * @returns The catalog.
+        */
+        const Catalog& getCatalog() const;
+
+        /**
+         * Clears all state sepecific to a customer session, e.g. to abandon a cart
+         * without checking out. Takes constant time and keeps the capacity of all containers,
+         * so registers do not allocate once they have served a few customers.
+        */
+        void clearSession();
+
+        /**
+         * Starts writing the register's scans, removals, checkouts and cancels to a journal. The
+         * lines of the open cart are written first, so the new journal alone recovers the cart.
+         * Checkouts wait until their event is durable before printing the receipt.
+         * @param journal The journal, which must outlive its use by the register, or nullptr to stop journaling.
+         * @param registerId The id of the register in the journal.
+        */
+        void setJournal(Journal* journal, std::uint32_t registerId);
+
+        /**
+         * Applies an event read back from a journal, to recover the register's open cart. Scans and
+         * removals of items that are no longer in the catalog are skipped, and checkouts and cancels
+         * clear the cart without printing a receipt. Call before setJournal, so the events are not
+         * journaled again.
+         * @param event The event.
+        */
+        void applyJournalEvent(const JournalEvent& event);
+
+        /**
+         * Recovers the open carts of registers from a journal file, then starts a new journal for the
+         * registers holding only their open carts, which replaces the journal file once it is durable.
+         * Throws a std::runtime_error, leaving the journal file as it is, if a register id beyond the
+         * given registers has an open cart.
+         * @param filepath The path of the journal file, which may not exist yet.
+         * @param registers The registers, indexed by their id in the journal. Events of other ids are
+         * only checked for open carts.
+         * @returns The new journal, which must outlive its use by the registers.
+        */
+        static std::unique_ptr<Journal> recoverJournal(const std::string& filepath, const std::vector<CheckoutRegister*>& registers);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,196 @@
+#ifndef CHECKOUT_STATS_H
+#define CHECKOUT_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+/**
+ * Optional instrumentation of the checkout hot paths, recording latency histograms and
+ * allocation counts of each phase and allocation counts of each cart.
+ * Recording is compiled in only when CHECKOUT_STATS is defined (build with `make STATS=1`).
+ * Otherwise the recording macros below expand to nothing and the snapshot is always empty.
+ * Each thread records into its own counters, so batch workers never contend.
+*/
+class CheckoutStats {
+    public:
+        /**
+         * The instrumented phases.
+        */
+        enum Phase {
+            ScanItem,
+            ScanBatch,
+            RemoveItem,
+            CalculateDeals,
+            PrintReceipt,
+            ClearSession,
+            LoadItems,
+            LoadDeals,
+            LoadSnapshot,
+            JournalCommit,
+            ReplayJournal,
+            PhaseCount
+        };
+
+        /**
+         * A histogram of values with a bucket per power of 2.
+        */
+        struct Histogram {
+            /**
+             * The number of values in each bucket. Bucket b holds values in [2^(b-1), 2^b),
+             * with bucket 0 holding zeros.
+            */
+            std::array<std::uint64_t, 65> buckets{};
+
+            /**
+             * The number of recorded values.
+            */
+            std::uint64_t count = 0;
+
+            /**
+             * The sum of the recorded values.
+            */
+            std::uint64_t total = 0;
+
+            /**
+             * The largest recorded value.
+            */
+            std::uint64_t max = 0;
+
+            /**
+             * Estimates a percentile of the recorded values as the upper bound of its bucket,
+             * capped at the largest recorded value.
+             * @param percent The percentile, from 0 to 100.
+             * @returns The estimate, or 0 if there are no values.
+            */
+            std::uint64_t percentile(double percent) const;
+        };
+
+        /**
+         * The statistics recorded by all threads.
+        */
+        struct Snapshot {
+            /**
+             * Latency in nanoseconds of each call, indexed by phase.
+            */
+            std::array<Histogram, PhaseCount> latency;
+
+            /**
+             * Total heap allocations made during calls, indexed by phase.
+            */
+            std::array<std::uint64_t, PhaseCount> allocations{};
+
+            /**
+             * Heap allocations made by the register for each checked out cart.
+            */
+            Histogram cartAllocations;
+        };
+
+        /**
+         * Checks whether recording is compiled in.
+         * @returns Whether CHECKOUT_STATS is defined.
+        */
+        static constexpr bool isEnabled() {
+        #ifdef CHECKOUT_STATS
+            return true;
+        #else
+            return false;
+        #endif
+        }
+
+        /**
+         * Gets the name of a phase.
+         * @param phase The phase.
+         * @returns The name.
+        */
+        static const char* phaseName(Phase phase);
+
+        /**
+         * Records a call of a phase on the calling thread.
+         * @param phase The phase.
+         * @param nanoseconds The latency of the call.
+         * @param allocations The heap allocations made during the call.
+        */
+        static void record(Phase phase, std::uint64_t nanoseconds, std::uint64_t allocations);
+
+        /**
+         * Records the allocations made by phases of the calling thread since the last cart ended
+         * as a single cart.
+        */
+        static void endCart();
+
+        /**
+         * Gets the number of heap allocations made by the calling thread.
+         * @returns The count, or 0 if recording is not compiled in.
+        */
+        static std::uint64_t threadAllocations();
+
+        /**
+         * Merges the statistics recorded by all threads, including threads that have exited.
+         * @returns The statistics.
+        */
+        static Snapshot snapshot();
+
+        /**
+         * Clears the statistics recorded by all threads.
+        */
+        static void reset();
+
+        /**
+         * Prints a table of the statistics recorded by all threads.
+         * @param out The output stream.
+        */
+        static void print(std::ostream& out);
+
+        /**
+         * Records the latency and allocations of a phase over the lifetime of the timer.
+        */
+        class ScopedTimer {
+            private:
+                /**
+                 * The phase.
+                */
+                Phase phase;
+
+                /**
+                 * The time the timer was created.
+                */
+                std::chrono::steady_clock::time_point start;
+
+                /**
+                 * The allocations of the calling thread when the timer was created.
+                */
+                std::uint64_t startAllocations;
+
+            public:
+                /**
+                 * Starts timing a phase.
+                 * @param phase The phase.
+                */
+                explicit ScopedTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()),
+                    startAllocations(threadAllocations()) {}
+
+                /**
+                 * Records the phase.
+                */
+                ~ScopedTimer() {
+                    auto elapsed = std::chrono::steady_clock::now() - start;
+                    record(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                           threadAllocations() - startAllocations);
+                }
+
+                ScopedTimer(const ScopedTimer&) = delete;
+                ScopedTimer& operator=(const ScopedTimer&) = delete;
+        };
+};
+
+#ifdef CHECKOUT_STATS
+    #define CHECKOUT_STATS_PHASE(phase) CheckoutStats::ScopedTimer checkoutStatsTimer(CheckoutStats::phase)
+    #define CHECKOUT_STATS_END_CART() CheckoutStats::endCart()
+#else
+    #define CHECKOUT_STATS_PHASE(phase)
+    #define CHECKOUT_STATS_END_CART()
+#endif
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/**
+ * Reports which instruction set extensions the processor supports, so kernels compiled for them
+ * are only called where they can run. Each feature is checked once and then cached.
+*/
+class CpuFeatures {
+    public:
+        /**
+         * Gets whether the processor supports AVX2. Always false when the compiler cannot build AVX2 code.
+         * @returns Whether AVX2 is supported.
+        */
+        static bool hasAvx2();
+};
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef DEAL_H
+#define DEAL_H
+
+#include "money.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The kinds of deals offered by the Supermarket.
+*/
+enum class DealType {
+    /**
+     * Buy any buyCount + freeCount units of the deal's items (duplicates allowed), and the
+     * freeCount cheapest of them are free. The original deals are Buy 2 Get 1.
+    */
+    BuyGetFree,
+
+    /**
+     * Buy itemCounts units of each of the deal's items together for a fixed bundle price.
+    */
+    Bundle
+};
+
+/**
+ * A read-only run of consecutive ids stored in one of the catalog's columns, valid until the
+ * catalog is changed.
+*/
+struct IdSpan {
+    /**
+     * The first id.
+    */
+    const int* first = nullptr;
+
+    /**
+     * The number of ids.
+    */
+    size_t count = 0;
+
+    const int* begin() const { return first; }
+    const int* end() const { return first + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    int operator[](size_t i) const { return first[i]; }
+};
+
+/**
+ * The terms of a deal of the Supermarket catalog, stored by the catalog in a column indexed by deal id.
+*/
+struct DealTerms {
+    /**
+     * The largest number of units a single deal group may contain.
+    */
+    static const int maxGroupSize = 16;
+
+    /**
+     * The kind of deal.
+    */
+    DealType type = DealType::BuyGetFree;
+
+    /**
+     * For BuyGetFree deals, the number of paid units in each group.
+    */
+    int buyCount = 2;
+
+    /**
+     * For BuyGetFree deals, the number of free units in each group.
+    */
+    int freeCount = 1;
+
+    /**
+     * For Bundle deals, the price of a whole bundle.
+    */
+    Money bundlePrice;
+
+    /**
+     * Gets whether the deal is the original Buy 2 Get 1 deal.
+     * @returns Whether the deal is Buy 2 Get 1.
+    */
+    bool isBuyTwoGetOne() const {
+        return type == DealType::BuyGetFree && buyCount == 2 && freeCount == 1;
+    }
+};
+
+/**
+ * A deal of the Supermarket catalog: its terms, and views of its items in the catalog's deal item
+ * columns. Deals are returned by value and stay valid until the catalog is changed.
+*/
+struct Deal : DealTerms {
+    /**
+     * The ids of the distinct items in the deal, ordered highest to lowest by price.
+    */
+    IdSpan itemIds;
+
+    /**
+     * The number of units of each item in a group, parallel to itemIds: the bundle counts for
+     * Bundle deals, and 1 for BuyGetFree deals.
+    */
+    IdSpan itemCounts;
+
+    /**
+     * Gets the number of units in each group of the deal.
+     * @returns The group size.
+    */
+    int groupSize() const {
+        if (type == DealType::BuyGetFree) {
+            return buyCount + freeCount;
+        }
+        int size = 0;
+        for (int count : itemCounts) {
+            size += count;
+        }
+        return size;
+    }
+};
+
+/**
+ * A set of deals connected through shared items. Each item belongs to at most one cluster, so
+ * the savings of a cart are the sum of the best savings of each cluster, found independently.
+ * Clusters are returned by value as views of the catalog's columns, and stay valid until the
+ * catalog is changed.
+*/
+struct DealCluster {
+    /**
+     * The ids of the deals in the cluster, in the order they were added to the catalog.
+    */
+    IdSpan dealIds;
+
+    /**
+     * The ids of all items of the cluster's deals, ordered highest to lowest by price. Items with
+     * equal prices keep the order they first appear in the cluster's deals, so a cluster with a
+     * single deal lists its items in the deal's own order.
+    */
+    IdSpan itemIds;
+
+    /**
+     * The catalog's offsets of each deal's items, indexed by deal id.
+    */
+    const std::uint64_t* dealOffsets = nullptr;
+
+    /**
+     * The catalog's column of deal slots, parallel to the deal item column.
+    */
+    const int* slots = nullptr;
+
+    /**
+     * The catalog's column of deal slot counts, parallel to the deal item column.
+    */
+    const int* slotCounts = nullptr;
+
+    /**
+     * Gets the positions of a deal's items within itemIds in ascending order, i.e. highest to
+     * lowest by price.
+     * @param dealIndex The position of the deal within dealIds.
+     * @returns The positions.
+    */
+    IdSpan dealSlots(size_t dealIndex) const {
+        int dealId = dealIds[dealIndex];
+        return {slots + dealOffsets[dealId], static_cast<size_t>(dealOffsets[dealId + 1] - dealOffsets[dealId])};
+    }
+
+    /**
+     * Gets the number of units of each item of a deal in a group, parallel to dealSlots: the
+     * bundle counts for Bundle deals, and 1 for BuyGetFree deals.
+     * @param dealIndex The position of the deal within dealIds.
+     * @returns The counts.
+    */
+    IdSpan dealSlotCounts(size_t dealIndex) const {
+        int dealId = dealIds[dealIndex];
+        return {slotCounts + dealOffsets[dealId], static_cast<size_t>(dealOffsets[dealId + 1] - dealOffsets[dealId])};
+    }
+};
+
+#endif
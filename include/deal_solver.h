@@ -0,0 +1,344 @@
+#ifndef DEAL_SOLVER_H
+#define DEAL_SOLVER_H
+
+#include "catalog.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * The deal groups chosen for a cart, stored as runs of units of the same item.
+*/
+struct DealPlan {
+    /**
+     * A run of units of a single item.
+    */
+    struct Run {
+        /**
+         * The item id.
+        */
+        int itemId;
+
+        /**
+         * The number of units of the item.
+        */
+        int quantity;
+    };
+
+    /**
+     * The groups of a single deal. Taking the units of its runs in order, every groupSize() consecutive
+     * units form a group of the deal, and the whole segment is repeated `repeat` times. The units of
+     * each BuyGetFree group are ordered highest to lowest by price, so its last freeCount units are free.
+    */
+    struct Segment {
+        /**
+         * The deal id.
+        */
+        int dealId;
+
+        /**
+         * The index of the first run of the segment.
+        */
+        int firstRun;
+
+        /**
+         * The number of runs in the segment.
+        */
+        int runCount;
+
+        /**
+         * The number of times the units of the runs are repeated.
+        */
+        int repeat;
+    };
+
+    /**
+     * The runs of all segments.
+    */
+    std::vector<Run> runs;
+
+    /**
+     * The segments, in the order their groups are listed on receipts.
+    */
+    std::vector<Segment> segments;
+
+    /**
+     * Removes all groups from the plan, keeping the capacity of its containers.
+    */
+    void clear() {
+        runs.clear();
+        segments.clear();
+    }
+};
+
+/**
+ * Finds the deal groups giving the most savings for the units of a cart in a deal cluster.
+ *
+ * A cluster with a single deal is solved in closed form: the most expensive units are grouped in
+ * price order, which is optimal for one deal. Overlapping deals are solved exactly by a memoized
+ * search over the remaining units of each item, which takes the most expensive remaining unit and
+ * either leaves it out of every group or forms each possible group containing it, pruned by an
+ * upper bound on the savings of the remaining units. Carts that would need more than the node
+ * budget fall back to applying each deal greedily in turn, and report the upper bound alongside
+ * the greedy savings so the gap to the optimum is known.
+*/
+class DealSolver {
+    public:
+        /**
+         * The outcome of solving a cluster.
+        */
+        struct Result {
+            /**
+             * The savings of the chosen groups.
+            */
+            Money savings;
+
+            /**
+             * A proven upper bound on the savings of any choice of groups, equal to savings when
+             * the choice is optimal.
+            */
+            Money upperBound;
+
+            /**
+             * Whether the chosen groups give the most savings possible.
+            */
+            bool isOptimal;
+
+            /**
+             * The number of search states explored.
+            */
+            long long nodes;
+        };
+
+        /**
+         * The default number of search states explored before falling back to the greedy groups.
+        */
+        static const int defaultNodeBudget = 20000;
+
+        /**
+         * Clusters with more units in the cart than this are never searched, which bounds the
+         * depth of the search.
+        */
+        static const int maxSearchUnits = 256;
+
+    private:
+        /**
+         * A slot of the memo table.
+        */
+        struct MemoSlot {
+            /**
+             * The solve the slot was written in. Slots of earlier solves are empty.
+            */
+            std::uint32_t stamp;
+
+            /**
+             * The index of the memo entry.
+            */
+            std::int32_t entry;
+        };
+
+        /**
+         * The number of search states explored before giving up on an exact solution, 0 to always use the greedy groups.
+        */
+        int nodeBudget;
+
+        /**
+         * The catalog of the cluster being solved.
+        */
+        const Catalog* catalog;
+
+        /**
+         * The cluster being solved.
+        */
+        DealCluster cluster;
+
+        /**
+         * The remaining units of each item of the cluster, in the cluster's item order.
+        */
+        std::vector<int> state;
+
+        /**
+         * The price in cents of each item of the cluster.
+        */
+        std::vector<std::int64_t> prices;
+
+        /**
+         * An upper bound on the savings each unit of each item of the cluster can contribute.
+        */
+        std::vector<double> unitBounds;
+
+        /**
+         * The upper bound on the savings of the remaining units, kept current with state.
+        */
+        double stateBound;
+
+        /**
+         * For each item of the cluster, the offset of its deals in slotDeals, as item count + 1 offsets.
+        */
+        std::vector<int> slotDealOffsets;
+
+        /**
+         * The positions within the cluster of the deals containing each item.
+        */
+        std::vector<int> slotDeals;
+
+        /**
+         * The next free position of each item's deals in slotDeals while the deal lists are built.
+        */
+        std::vector<int> slotDealCursors;
+
+        /**
+         * For each deal of the cluster, the savings of one bundle, or 0 for BuyGetFree deals.
+        */
+        std::vector<std::int64_t> bundleSavings;
+
+        /**
+         * The number of search states explored in the current solve.
+        */
+        long long nodes;
+
+        /**
+         * Whether the current search ran out of its node budget.
+        */
+        bool isAborted;
+
+        /**
+         * Open addressing hash table of explored states, at most half full.
+        */
+        std::vector<MemoSlot> memoSlots;
+
+        /**
+         * The stamp of the current solve, so the memo table can be emptied without clearing it.
+        */
+        std::uint32_t memoStamp;
+
+        /**
+         * The states of the memo entries, each of them the size of the cluster's item list.
+        */
+        std::vector<int> memoKeys;
+
+        /**
+         * The hashes of the memo entries.
+        */
+        std::vector<std::uint64_t> memoHashes;
+
+        /**
+         * The best savings in cents of the memo entries.
+        */
+        std::vector<std::int64_t> memoValues;
+
+        /**
+         * The offset of the best group of each memo entry in memoGroups, or -1 if the best choice
+         * leaves the most expensive unit out of every group.
+        */
+        std::vector<int> memoChoices;
+
+        /**
+         * The best groups of memo entries, each stored as the position of its deal within the
+         * cluster followed by the other units of a BuyGetFree group.
+        */
+        std::vector<int> memoGroups;
+
+        /**
+         * The outcome of the last solve.
+        */
+        Result result;
+
+        /**
+         * Applies a single deal in closed form to the remaining units of each item.
+         * @param dealIndex The position of the deal within the cluster.
+         * @param remaining The remaining units of each item of the cluster, reduced by the grouped units.
+         * @param plan The plan to add the groups to, or nullptr if only the savings are needed.
+         * @returns The savings in cents.
+        */
+        std::int64_t applyDeal(int dealIndex, int* remaining, DealPlan* plan) const;
+
+        /**
+         * Prepares the item prices, bounds and deal lists of the cluster for searching.
+        */
+        void prepareSearch();
+
+        /**
+         * Finds the best savings of the remaining units in state, which is unchanged on return.
+         * @param top The position of the first item that may have remaining units.
+         * @returns The savings in cents, or 0 if the search was aborted.
+        */
+        std::int64_t search(int top);
+
+        /**
+         * Forms each possible BuyGetFree group from the remaining units in state, choosing its units
+         * one at a time in price order, and searches the units remaining after each complete group.
+         * @param dealIndex The position of the deal within the cluster.
+         * @param top The position of the most expensive remaining item, whose unit starts the group.
+         * @param picks The positions of the items of the units chosen so far, after the top unit.
+         * @param pickCount The number of units chosen so far.
+         * @param listPos The position within the deal's item list to choose the next unit from.
+         * @param best The best savings found so far, updated when a group improves on it.
+         * @param bestPicks Set to the units of the best group when it improves.
+        */
+        void searchGroups(int dealIndex, int top, int* picks, int pickCount, size_t listPos,
+                          std::int64_t& best, int* bestPicks);
+
+        /**
+         * Adds the groups of the best choice found by the search for the starting state to a plan.
+         * @param quantities The starting units of each item of the cluster.
+         * @param plan The plan.
+        */
+        void reconstruct(const int* quantities, DealPlan& plan);
+
+        /**
+         * Adds a single group to a plan, repeating the last segment instead if it holds the same group.
+         * @param dealIndex The position of the deal within the cluster.
+         * @param slots The positions of the items of the group's units, in price order.
+         * @param count The number of units.
+         * @param firstSegment The first segment added by the current solve, which may be repeated.
+         * @param plan The plan.
+        */
+        void addGroup(int dealIndex, const int* slots, int count, size_t firstSegment, DealPlan& plan) const;
+
+        /**
+         * Hashes the remaining units in state.
+         * @returns The hash.
+        */
+        std::uint64_t hashState() const;
+
+        /**
+         * Finds the memo entry of the remaining units in state.
+         * @param hash The hash of state.
+         * @returns The entry, or -1 if the state has not been explored.
+        */
+        int findMemo(std::uint64_t hash) const;
+
+        /**
+         * Adds a memo entry for the remaining units in state.
+         * @param hash The hash of state.
+         * @param value The best savings in cents.
+         * @param choice The offset of the best group in memoGroups, or -1.
+        */
+        void addMemo(std::uint64_t hash, std::int64_t value, int choice);
+
+    public:
+        /**
+         * Instantiates a solver.
+         * @param nodeBudget The number of search states explored before falling back to the greedy groups.
+        */
+        explicit DealSolver(int nodeBudget = defaultNodeBudget);
+
+        /**
+         * Sets the number of search states explored before falling back to the greedy groups.
+         * @param nodeBudget The budget, 0 to always use the greedy groups.
+        */
+        void setNodeBudget(int nodeBudget);
+
+        /**
+         * Finds the deal groups giving the most savings for the units of a cart in a deal cluster.
+         * @param catalog The catalog.
+         * @param clusterId The cluster id.
+         * @param quantities The units of each item of the cluster in the cart, in the cluster's item order.
+         * @param plan The plan to add the chosen groups to, or nullptr if only the savings are needed.
+         * @returns The outcome, valid until the next solve.
+        */
+        const Result& solve(const Catalog& catalog, int clusterId, const int* quantities, DealPlan* plan);
+};
+
+#endif
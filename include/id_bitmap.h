@@ -0,0 +1,143 @@
+#ifndef ID_BITMAP_H
+#define ID_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A set of ids from 0 to a fixed capacity, stored as one bit per id. A summary bitmap holds one bit
+ * per word of the id bitmap, set while the word has any id in it, and a stack holds the index of each
+ * non-zero summary word. Clearing the set only visits the words holding ids, so it costs the same
+ * however large the capacity is. Iterating visits the words holding ids plus every summary word, one
+ * per 4096 ids of capacity, so that ids are always visited in ascending order and no sorting is needed
+ * to process them in a stable order.
+*/
+class IdBitmap {
+    private:
+        /**
+         * The number of ids stored in each word.
+        */
+        static const int wordBits = 64;
+
+        /**
+         * One bit per id, set if the id is in the set.
+        */
+        std::vector<std::uint64_t> words;
+
+        /**
+         * One bit per word of words, set if the word has any bit set.
+        */
+        std::vector<std::uint64_t> summary;
+
+        /**
+         * A stack of the indexes of the non-zero words of summary, in the order they were set. It has a
+         * slot for every summary word plus a spare one that insert writes to when the stack is full.
+        */
+        std::vector<std::uint32_t> setSummaryIndexes;
+
+        /**
+         * The number of indexes on the setSummaryIndexes stack.
+        */
+        size_t setSummaryCount;
+
+        /**
+         * The number of ids in the set.
+        */
+        size_t count;
+
+        /**
+         * Gets the position of the lowest set bit of a word.
+         * @param word The word, which must not be 0.
+         * @returns The position of the bit, from 0 to 63.
+        */
+        static int lowestBit(std::uint64_t word) {
+#ifdef __GNUC__
+            return __builtin_ctzll(word);
+#else
+            int bit = 0;
+            while ((word & 1) == 0) {
+                word >>= 1;
+                bit++;
+            }
+            return bit;
+#endif
+        }
+
+    public:
+        /**
+         * Instantiates an empty set with a capacity of 0.
+        */
+        IdBitmap();
+
+        /**
+         * Empties the set and sets the range of ids it can hold.
+         * @param capacity The number of ids, which range from 0 to capacity - 1.
+        */
+        void resize(size_t capacity);
+
+        /**
+         * Adds an id to the set in constant time.
+         * @param id The id, which must be less than the capacity.
+         * @returns Whether the id was added, false if it was already in the set.
+        */
+        bool insert(int id) {
+            std::uint64_t& word = words[id / wordBits];
+            std::uint64_t bit = std::uint64_t(1) << (id % wordBits);
+            if (word & bit) {
+                return false;
+            }
+            if (word == 0) {
+                // Always write the summary index above the stack, and only keep it if the summary word
+                // was empty, since whether it was is too random to branch on
+                std::uint64_t& summaryWord = summary[id / wordBits / wordBits];
+                setSummaryIndexes[setSummaryCount] = static_cast<std::uint32_t>(id / wordBits / wordBits);
+                setSummaryCount += summaryWord == 0;
+                summaryWord |= std::uint64_t(1) << (id / wordBits % wordBits);
+            }
+            word |= bit;
+            count++;
+            return true;
+        }
+
+        /**
+         * Gets whether an id is in the set.
+         * @param id The id, which must be less than the capacity.
+         * @returns Whether the id is in the set.
+        */
+        bool contains(int id) const {
+            return (words[id / wordBits] >> (id % wordBits)) & 1;
+        }
+
+        /**
+         * Gets the number of ids in the set.
+         * @returns The number of ids.
+        */
+        size_t size() const {
+            return count;
+        }
+
+        /**
+         * Removes every id from the set, only visiting the words holding ids and their summary words.
+        */
+        void clear();
+
+        /**
+         * Calls a function with each id of the set in ascending order. The set must not be changed
+         * until the iteration ends.
+         * @param visit The function, called with each id.
+        */
+        template <typename Function>
+        void forEach(Function visit) const {
+            for (size_t summaryIndex = 0; summaryIndex < summary.size(); ++summaryIndex) {
+                for (std::uint64_t wordsLeft = summary[summaryIndex]; wordsLeft != 0; wordsLeft &= wordsLeft - 1) {
+                    size_t wordIndex = summaryIndex * wordBits + lowestBit(wordsLeft);
+                    for (std::uint64_t idsLeft = words[wordIndex]; idsLeft != 0; idsLeft &= idsLeft - 1) {
+                        visit(static_cast<int>(wordIndex * wordBits + lowestBit(idsLeft)));
+                    }
+                }
+            }
+        }
+};
+
+#endif
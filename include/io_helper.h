@@ -2,6 +2,7 @@
 #define IO_HELPER_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
 
 /**
@@ -9,6 +10,26 @@
 */
 class IOHelper {
 public:
+    /**
+     * The outcome of parsing a number.
+    */
+    enum class ParseStatus {
+        /**
+         * The whole string is a number in range.
+        */
+        Ok,
+
+        /**
+         * The string is not a number, or has characters after the number.
+        */
+        Invalid,
+
+        /**
+         * The string is a number too large or small for the result type.
+        */
+        OutOfRange
+    };
+
     /**
      * Prints a string centered in a specified total width.
      * @param str The string.
@@ -33,14 +54,52 @@ public:
 
     /**
      * Converts an input string to Camel Case in place by capitalizing the first character
-     * in the string and after spaces.
+     * in the string and after spaces. ASCII text is converted 16 or 32 bytes at a time with SSE2
+     * or AVX2 where the processor supports it, and blocks holding other bytes are converted one
+     * byte at a time like toCamelCaseScalar, so the result is always the same.
      * @param str The input string.
     */
     static void toCamelCase(std::string& str);
 
     /**
-     * Converts a string to an int using std::stoi. Checks that
-     * the full string is numeric and convertable to an int, else throws an exception.
+     * Converts an input string to Camel Case in place one byte at a time, with the character
+     * classification of the C locale.
+     * @param str The input string.
+    */
+    static void toCamelCaseScalar(std::string& str);
+
+    /**
+     * Reads the next field of a string of fields separated by a delimiter without copying it,
+     * splitting the same way as std::getline, so a trailing delimiter does not start another field.
+     * @param str The string.
+     * @param pos The position of the start of the field, moved to the start of the following field.
+     * @param delimiter The delimiter, such as ',' or '\n'.
+     * @param field Set to the field, excluding its delimiter.
+     * @returns Whether a field was read.
+    */
+    static bool nextField(std::string_view str, size_t& pos, char delimiter, std::string_view& field);
+
+    /**
+     * Reads the next word of a string of words separated by whitespace without copying it.
+     * @param str The string.
+     * @param pos The position to search for the word from, moved to the end of the word.
+     * @param word Set to the word.
+     * @returns Whether a word was read.
+    */
+    static bool nextWord(std::string_view str, size_t& pos, std::string_view& word);
+
+    /**
+     * Converts a string to an int without throwing, accepting the same strings as fullStoi: optional
+     * leading whitespace and sign followed by decimal digits, and nothing else.
+     * @param str The input string.
+     * @param value Set to the int if the status is ParseStatus::Ok.
+     * @returns The status.
+    */
+    static ParseStatus parseInt(std::string_view str, int& value);
+
+    /**
+     * Converts a string to an int. Checks that the full string is numeric and convertable to an int,
+     * else throws std::invalid_argument or std::out_of_range like std::stoi.
      * @param str The input string.
     */
     static int fullStoi(const std::string& str);
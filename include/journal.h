@@ -0,0 +1,207 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * The kinds of events written to a journal.
+*/
+enum class JournalEventType : std::uint8_t {
+    /**
+     * A quantity of an item was scanned into the cart.
+    */
+    Scan = 1,
+
+    /**
+     * An item was removed from the cart.
+    */
+    Remove = 2,
+
+    /**
+     * The cart was checked out.
+    */
+    Checkout = 3,
+
+    /**
+     * The cart was abandoned without checking out.
+    */
+    Cancel = 4
+};
+
+/**
+ * An event read back from a journal.
+*/
+struct JournalEvent {
+    /**
+     * The kind of event.
+    */
+    JournalEventType type;
+
+    /**
+     * The id of the register the event happened on.
+    */
+    std::uint32_t registerId;
+
+    /**
+     * The item name of a scan or removal, only valid while the event is being replayed.
+    */
+    std::string_view itemName;
+
+    /**
+     * The quantity of a scan, else 0.
+    */
+    int quantity;
+};
+
+/**
+ * An append-only binary log of the scan, remove, checkout and cancel events of registers, so that
+ * open carts can be recovered after a crash by replaying it. All integers are little endian.
+ *
+ * Record:
+ *   u32 length of the rest of the record in bytes
+ *   u32 FNV-1a checksum of the rest of the record
+ *   u8  event type
+ *   u32 register id
+ *   i32 quantity
+ *   u16 item name length, followed by the name bytes
+ *
+ * Appending an event only copies its record into a buffer. A commit thread writes the buffer to the
+ * file and syncs it to disk, and the events appended while one sync is in progress all share the
+ * next one (group commit), so registers never wait on the disk for each scan. Checkouts wait until
+ * their record is durable before the receipt is printed.
+ *
+ * A journal always starts a new log, written next to the journal file and moved over it by
+ * publish(), so the previous log stays intact until its open carts have been replayed and written
+ * to the new one.
+*/
+class Journal {
+    private:
+        /**
+         * The path of the journal file.
+        */
+        std::string filepath;
+
+        /**
+         * The path the log is written to until it is published.
+        */
+        std::string pendingPath;
+
+        /**
+         * The descriptor of the log file.
+        */
+        int fd;
+
+        /**
+         * Guards all of the state below.
+        */
+        std::mutex mutex;
+
+        /**
+         * Wakes the commit thread when records are appended or the journal closes.
+        */
+        std::condition_variable appended;
+
+        /**
+         * Wakes threads waiting for records to become durable.
+        */
+        std::condition_variable committed;
+
+        /**
+         * The records appended since the commit thread last took the buffer.
+        */
+        std::string buffer;
+
+        /**
+         * The number of events appended.
+        */
+        std::uint64_t appendedCount;
+
+        /**
+         * The number of events written and synced to disk.
+        */
+        std::uint64_t durableCount;
+
+        /**
+         * The number of syncs made by the commit thread.
+        */
+        std::uint64_t commitCount;
+
+        /**
+         * Whether writing the log failed, after which events are no longer written.
+        */
+        bool isFailed;
+
+        /**
+         * Set to stop the commit thread once the buffer is empty.
+        */
+        bool isClosing;
+
+        /**
+         * Writes and syncs the buffer until the journal closes.
+        */
+        std::thread commitThread;
+
+        /**
+         * Runs the commit thread.
+        */
+        void runCommits();
+
+    public:
+        /**
+         * Starts a new, empty log for a journal file. Throws a std::runtime_error if it cannot be created.
+         * @param filepath The path of the journal file, which is only replaced once the log is published.
+        */
+        explicit Journal(const std::string& filepath);
+
+        /**
+         * Writes all appended events and closes the log.
+        */
+        ~Journal();
+
+        /**
+         * Appends an event without waiting for it to be written. Safe to call from any thread.
+         * Item names longer than a u16 length are truncated.
+         * @param type The kind of event.
+         * @param registerId The id of the register the event happened on.
+         * @param itemName The item name of a scan or removal.
+         * @param quantity The quantity of a scan.
+         * @returns The sequence number of the event, to wait for with waitUntilDurable.
+        */
+        std::uint64_t append(JournalEventType type, std::uint32_t registerId, std::string_view itemName = {}, int quantity = 0);
+
+        /**
+         * Waits until an event and every event appended before it are synced to disk.
+         * @param sequence The sequence number returned by append.
+         * @returns Whether the event is durable, false if writing the log failed.
+        */
+        bool waitUntilDurable(std::uint64_t sequence);
+
+        /**
+         * Waits until every appended event is synced to disk, then moves the log over the journal file
+         * so that it replaces the previous log. Throws a std::runtime_error if this fails.
+        */
+        void publish();
+
+        /**
+         * Gets the number of syncs made so far, each of which committed a group of events.
+         * @returns The number of syncs.
+        */
+        std::uint64_t getCommitCount();
+
+        /**
+         * Reads every event of a journal file in order. Reading stops at the first incomplete or
+         * corrupt record, which is where a crash interrupted the last write.
+         * @param filepath The path of the journal file. A missing file has no events.
+         * @param apply Called with each event.
+         * @returns The number of events read.
+        */
+        static size_t replay(const std::string& filepath, const std::function<void(const JournalEvent&)>& apply);
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef JSON_RECEIPT_SINK_H
+#define JSON_RECEIPT_SINK_H
+
+#include "receipt_sink.h"
+#include "receipt_writer.h"
+
+/**
+ * Writes receipts as JSON Lines, one object per receipt on its own line. Amounts are whole cents:
+ * {"cart":1,"time":1700000000,"deal_groups":[{"price_cents":400,"savings_cents":200,"bundle":false,
+ *  "lines":[{"item":"Soda","quantity":2,"price_cents":400,"free":false},...]}],
+ *  "items":[{"item":"Bananas","quantity":2,"price_cents":120}],"savings_cents":200,"total_cents":520}
+ * The cart field is only present for receipts of batch carts.
+*/
+class JsonReceiptSink : public ReceiptSink {
+    private:
+        /**
+         * The output stream.
+        */
+        std::ostream& out;
+
+        /**
+         * Formats each receipt, reused so its buffer is only allocated once.
+        */
+        ReceiptWriter writer;
+
+    public:
+        /**
+         * Instantiates a sink.
+         * @param out The output stream, which must outlive the sink.
+        */
+        explicit JsonReceiptSink(std::ostream& out);
+
+        void write(const Receipt& receipt) override;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * A read-only view of a whole file's contents.
+ * The file is memory mapped where supported, so its contents can be scanned without copying.
+*/
+class MappedFile {
+    private:
+        /**
+         * Pointer to the first byte of the file contents.
+        */
+        const char* data;
+
+        /**
+         * The size of the file contents in bytes.
+        */
+        size_t size;
+
+        /**
+         * Whether the file was opened successfully.
+        */
+        bool open;
+
+        /**
+         * Holds the file contents if the file cannot be memory mapped.
+        */
+        std::string buffer;
+
+    public:
+        /**
+         * Opens and maps a file. Check isOpen() to see if this succeeded.
+         * @param filepath The path to the file.
+        */
+        explicit MappedFile(const std::string& filepath);
+
+        /**
+         * Unmaps the file.
+        */
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * Checks if the file was opened successfully.
+         * @returns Whether the file is open.
+        */
+        bool isOpen() const;
+
+        /**
+         * Gets the contents of the file.
+         * @returns A view of the contents, valid for the lifetime of this object.
+        */
+        std::string_view contents() const;
+};
+
+#endif
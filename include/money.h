@@ -0,0 +1,77 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * An amount of money in USD, stored as a whole number of cents so that all sums are exact.
+*/
+class Money {
+    private:
+        /**
+         * The amount in cents.
+        */
+        std::int64_t cents;
+
+    public:
+        /**
+         * The maximum number of characters written by format().
+        */
+        static const int maxFormattedLength = 24;
+
+        /**
+         * Instantiates an amount of $0.00.
+        */
+        constexpr Money() : cents(0) {}
+
+        /**
+         * Instantiates an amount from a number of cents.
+         * @param cents The amount in cents.
+        */
+        constexpr explicit Money(std::int64_t cents) : cents(cents) {}
+
+        /**
+         * Gets the amount in cents.
+         * @returns The amount in cents.
+        */
+        constexpr std::int64_t getCents() const { return cents; }
+
+        /**
+         * Parses an amount of dollars such as "1.50", "2" or "0.5", rounding to the nearest cent.
+         * Surrounding whitespace is ignored.
+         * @param str The input string.
+         * @param amount Set to the parsed amount if parsing succeeds.
+         * @returns Whether the full string is a valid amount.
+        */
+        static bool parse(std::string_view str, Money& amount);
+
+        /**
+         * Formats the amount as "$X.YY" without going through a stream.
+         * @param buffer The buffer to write to, at least maxFormattedLength characters long.
+         * The buffer is not null terminated.
+         * @returns The number of characters written.
+        */
+        int format(char* buffer) const;
+
+        /**
+         * Formats the amount as "$X.YY".
+         * @returns The formatted amount.
+        */
+        std::string toString() const;
+
+        constexpr Money operator+(Money other) const { return Money(cents + other.cents); }
+        constexpr Money operator-(Money other) const { return Money(cents - other.cents); }
+        constexpr Money operator*(std::int64_t quantity) const { return Money(cents * quantity); }
+        Money& operator+=(Money other) { cents += other.cents; return *this; }
+        Money& operator-=(Money other) { cents -= other.cents; return *this; }
+        constexpr bool operator==(Money other) const { return cents == other.cents; }
+        constexpr bool operator!=(Money other) const { return cents != other.cents; }
+        constexpr bool operator<(Money other) const { return cents < other.cents; }
+        constexpr bool operator>(Money other) const { return cents > other.cents; }
+        constexpr bool operator<=(Money other) const { return cents <= other.cents; }
+        constexpr bool operator>=(Money other) const { return cents >= other.cents; }
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef PRICING_KERNEL_H
+#define PRICING_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Prices the lines of a cart from a column of unit prices and a column of quantities, both parallel
+ * to the cart lines.
+ *
+ * In optimized builds, lines are priced four at a time with AVX2 where the processor supports it,
+ * multiplying the unit prices by the quantities as 64 bit integers. Other processors and builds use
+ * the scalar kernel, which gives exactly the same line prices and total since both are integer
+ * arithmetic in cents.
+*/
+class PricingKernel {
+    public:
+        /**
+         * Prices cart lines one at a time.
+         * @param unitPrices The unit price in cents of each line.
+         * @param quantities The quantity of each line.
+         * @param count The number of lines.
+         * @param linePrices Set to the price in cents of each line.
+         * @returns The sum of the line prices in cents.
+        */
+        static std::int64_t priceLinesScalar(const std::int64_t* unitPrices, const int* quantities, size_t count,
+                                             std::int64_t* linePrices);
+
+        /**
+         * Prices cart lines four at a time with AVX2. Only call if CpuFeatures::hasAvx2() is true.
+         * @param unitPrices The unit price in cents of each line.
+         * @param quantities The quantity of each line, which must not be negative.
+         * @param count The number of lines.
+         * @param linePrices Set to the price in cents of each line.
+         * @returns The sum of the line prices in cents.
+        */
+        static std::int64_t priceLinesAvx2(const std::int64_t* unitPrices, const int* quantities, size_t count,
+                                           std::int64_t* linePrices);
+
+        /**
+         * Prices cart lines with the fastest kernel the processor supports, which is always the scalar
+         * kernel in unoptimized builds.
+         * @param unitPrices The unit price in cents of each line.
+         * @param quantities The quantity of each line, which must not be negative.
+         * @param count The number of lines.
+         * @param linePrices Set to the price in cents of each line.
+         * @returns The sum of the line prices in cents.
+        */
+        static std::int64_t priceLines(const std::int64_t* unitPrices, const int* quantities, size_t count,
+                                       std::int64_t* linePrices);
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef RECEIPT_H
+#define RECEIPT_H
+
+#include "money.h"
+
+#include <ctime>
+#include <string_view>
+#include <vector>
+
+/**
+ * A line of a receipt.
+*/
+struct ReceiptLine {
+    /**
+     * The item name. Views the catalog the receipt was priced against.
+    */
+    std::string_view name;
+
+    /**
+     * The number of units of the item on the line.
+    */
+    int quantity;
+
+    /**
+     * The price paid for all units on the line, $0.00 for free items.
+    */
+    Money price;
+
+    /**
+     * The index of the deal group the line belongs to, or -1 for remaining items.
+    */
+    int dealGroup;
+
+    /**
+     * Whether the line holds free items of its deal group.
+    */
+    bool isFree;
+};
+
+/**
+ * A deal group of a receipt.
+*/
+struct ReceiptDealGroup {
+    /**
+     * The price paid for the whole group.
+    */
+    Money price;
+
+    /**
+     * The savings of the group.
+    */
+    Money savings;
+
+    /**
+     * Whether the group is a bundle sold for a fixed price, whose lines show the regular
+     * prices of its items, rather than a group with free items.
+    */
+    bool isBundle;
+};
+
+/**
+ * The structured contents of a receipt, from which every receipt format is rendered.
+*/
+struct Receipt {
+    /**
+     * The id of the cart, or -1 if the receipt is not part of a batch.
+    */
+    int cartId = -1;
+
+    /**
+     * The time of checkout.
+    */
+    std::time_t time = 0;
+
+    /**
+     * The lines of all deal groups in order. Consecutive units of the same item in a group are
+     * combined into one line unless only some of them are free, and groups with free items end
+     * with their free lines.
+    */
+    std::vector<ReceiptLine> dealLines;
+
+    /**
+     * The deal groups, indexed by the dealGroup of their lines.
+    */
+    std::vector<ReceiptDealGroup> dealGroups;
+
+    /**
+     * The lines of items not included in deal groups, in the order they were first scanned.
+    */
+    std::vector<ReceiptLine> items;
+
+    /**
+     * The total savings of all deal groups.
+    */
+    Money savings;
+
+    /**
+     * The grand total paid.
+    */
+    Money total;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef RECEIPT_SINK_H
+#define RECEIPT_SINK_H
+
+#include "receipt.h"
+
+#include <iostream>
+#include <memory>
+#include <string_view>
+
+/**
+ * The formats receipts can be written in.
+*/
+enum class ReceiptFormat {
+    /**
+     * The human readable receipt.
+    */
+    Text,
+
+    /**
+     * One JSON object per line.
+    */
+    JsonLines,
+
+    /**
+     * Compact length prefixed binary records.
+    */
+    Binary
+};
+
+/**
+ * A destination for receipts in a particular format. A sink writes to a stream that stays open
+ * for all of its receipts, so many receipts can be appended to one file.
+*/
+class ReceiptSink {
+    public:
+        virtual ~ReceiptSink() = default;
+
+        /**
+         * Writes a receipt and flushes the stream, so the receipt is complete as soon as the cart is
+         * checked out.
+         * @param receipt The receipt.
+        */
+        virtual void write(const Receipt& receipt) = 0;
+
+        /**
+         * Creates a sink for a format.
+         * @param format The format.
+         * @param out The output stream, which must outlive the sink.
+         * @returns The sink.
+        */
+        static std::unique_ptr<ReceiptSink> create(ReceiptFormat format, std::ostream& out);
+
+        /**
+         * Parses the name of a format: `text`, `jsonl` or `binary`.
+         * @param name The name.
+         * @param format Set to the format if the name is valid.
+         * @returns Whether the name is valid.
+        */
+        static bool parseFormat(std::string_view name, ReceiptFormat& format);
+
+        /**
+         * Gets the file extension of a format.
+         * @param format The format.
+         * @returns The extension, without a leading dot.
+        */
+        static const char* fileExtension(ReceiptFormat format);
+};
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef RECEIPT_WRITER_H
+#define RECEIPT_WRITER_H
+
+#include "money.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+
+/**
+ * Formats receipts and other tables into a single reusable text buffer, producing the same text as
+ * the equivalent stream insertions with std::setw, then writes the whole buffer at once.
+ * The buffer keeps its capacity between uses, so a writer reused for many receipts stops allocating.
+*/
+class ReceiptWriter {
+    private:
+        /**
+         * The formatted text.
+        */
+        std::string buffer;
+
+    public:
+        /**
+         * Instantiates an empty writer.
+         * @param capacity The number of characters to reserve in the buffer.
+        */
+        explicit ReceiptWriter(size_t capacity = 4096);
+
+        /**
+         * Discards the formatted text, keeping the capacity of the buffer.
+        */
+        void clear();
+
+        /**
+         * Gets the formatted text.
+         * @returns The text.
+        */
+        std::string_view text() const;
+
+        /**
+         * Writes the formatted text to an output stream with a single write, then clears it.
+         * @param out The output stream.
+        */
+        void writeTo(std::ostream& out);
+
+        /**
+         * Appends text.
+         * @param str The text.
+        */
+        void append(std::string_view str);
+
+        /**
+         * Appends an integer.
+         * @param value The integer.
+        */
+        void append(long long value);
+
+        /**
+         * Appends an amount of money formatted as "$X.YY".
+         * @param amount The amount.
+        */
+        void append(Money amount);
+
+        /**
+         * Appends a new line.
+        */
+        void endLine();
+
+        /**
+         * Gets the position of the end of the text, to later pad a field that starts there.
+         * @returns The position.
+        */
+        size_t mark() const;
+
+        /**
+         * Left justifies the field from a mark to the end of the text by appending spaces until it
+         * is at least a width long.
+         * @param fieldStart The mark of the start of the field.
+         * @param width The width of the field.
+        */
+        void padFrom(size_t fieldStart, int width);
+
+        /**
+         * Appends text left justified in a field of a width.
+         * @param str The text.
+         * @param width The width of the field.
+        */
+        void appendLeft(std::string_view str, int width);
+
+        /**
+         * Appends text right justified in a field of a width.
+         * @param str The text.
+         * @param width The width of the field.
+        */
+        void appendRight(std::string_view str, int width);
+
+        /**
+         * Appends an integer right justified in a field of a width.
+         * @param value The integer.
+         * @param width The width of the field.
+        */
+        void appendRight(long long value, int width);
+
+        /**
+         * Appends an amount of money formatted as "$X.YY", right justified in a field of a width.
+         * @param amount The amount.
+         * @param width The width of the field.
+        */
+        void appendRight(Money amount, int width);
+
+        /**
+         * Appends a line of text centered in a width, matching IOHelper::printCentered.
+         * @param str The text.
+         * @param totalWidth The width to center the text in.
+        */
+        void centeredLine(std::string_view str, int totalWidth);
+
+        /**
+         * Appends a solid line, matching IOHelper::printSolidLine.
+         * @param length The length of the line.
+        */
+        void solidLine(int length);
+
+        /**
+         * Appends a dashed line, matching IOHelper::printDashedLine.
+         * @param length The length of the line.
+        */
+        void dashedLine(int length);
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SCAN_BATCH_H
+#define SCAN_BATCH_H
+
+#include <string_view>
+
+/**
+ * A single scan of a batch passed to CheckoutRegister::scanBatch.
+*/
+struct ScanEntry {
+    /**
+     * The scanned item name, only read if itemId is -1. The name must stay valid until the batch
+     * has been scanned.
+    */
+    std::string_view itemName;
+
+    /**
+     * The scanned item id, or -1 to look the item up by name.
+    */
+    int itemId = -1;
+
+    /**
+     * The scanned quantity.
+    */
+    int quantity = 0;
+};
+
+/**
+ * The outcome of a single scan of a batch, or of scanning or removing a single item without throwing.
+*/
+enum class ScanStatus {
+    /**
+     * The quantity was added to the cart.
+    */
+    Ok,
+
+    /**
+     * The quantity was smaller than 1, so nothing was added.
+    */
+    InvalidQuantity,
+
+    /**
+     * No item of the catalog has the scanned name or id, so nothing was added.
+    */
+    UnknownItem,
+
+    /**
+     * The item to remove is not in the cart. Only reported by CheckoutRegister::tryRemoveItem.
+    */
+    NotInCart
+};
+
+#endif
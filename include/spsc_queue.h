@@ -0,0 +1,88 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * A bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * @tparam T The type of the queued values.
+*/
+template <typename T>
+class SpscQueue {
+    private:
+        /**
+         * The size of a cache line, so the producer and consumer indices never share one.
+        */
+        static const size_t cacheLine = 64;
+
+        /**
+         * The slots of the ring buffer. The capacity is a power of 2 so indices wrap with a mask.
+        */
+        std::unique_ptr<T[]> slots;
+
+        /**
+         * The capacity minus 1.
+        */
+        size_t mask;
+
+        /**
+         * The total number of values pushed, only written by the producer.
+        */
+        alignas(cacheLine) std::atomic<size_t> tail;
+
+        /**
+         * The total number of values popped, only written by the consumer.
+        */
+        alignas(cacheLine) std::atomic<size_t> head;
+
+    public:
+        /**
+         * Instantiates an empty queue.
+         * @param capacity The minimum number of values the queue can hold, rounded up to a power of 2.
+        */
+        explicit SpscQueue(size_t capacity) : tail(0), head(0) {
+            size_t size = 1;
+            while (size < capacity) {
+                size *= 2;
+            }
+            slots.reset(new T[size]);
+            mask = size - 1;
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        /**
+         * Adds a value to the back of the queue. Only called by the producer.
+         * @param value The value, moved into the queue if there is room.
+         * @returns Whether there was room for the value.
+        */
+        bool tryPush(T& value) {
+            size_t position = tail.load(std::memory_order_relaxed);
+            if (position - head.load(std::memory_order_acquire) > mask) {
+                return false;
+            }
+            slots[position & mask] = std::move(value);
+            tail.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Removes the value at the front of the queue. Only called by the consumer.
+         * @param value Set to the value if the queue is not empty.
+         * @returns Whether the queue was not empty.
+        */
+        bool tryPop(T& value) {
+            size_t position = head.load(std::memory_order_relaxed);
+            if (position == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = std::move(slots[position & mask]);
+            head.store(position + 1, std::memory_order_release);
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef STORE_SERVER_H
+#define STORE_SERVER_H
+
+#include "catalog_manager.h"
+#include "checkout_register.h"
+#include "spsc_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs many checkout lanes at once, each with its own CheckoutRegister, against a shared catalog.
+ * Lanes are spread across worker threads that each own their lanes' registers outright, so scanning
+ * never takes a lock. Commands reach a worker through its own single producer queue, and only
+ * responses (errors, carts and receipts) are serialized onto the shared output stream.
+*/
+class StoreServer {
+    private:
+        /**
+         * A command line for a lane.
+        */
+        struct Command {
+            /**
+             * The lane the command is for.
+            */
+            int lane;
+
+            /**
+             * The command, in the same format as interactive input.
+            */
+            std::string text;
+
+            /**
+             * The time the command was submitted.
+            */
+            std::chrono::steady_clock::time_point submitted;
+        };
+
+        /**
+         * A worker thread and the lanes it owns.
+        */
+        struct Worker {
+            /**
+             * The commands for the worker's lanes, pushed only by the submitting thread.
+            */
+            SpscQueue<Command> queue;
+
+            /**
+             * The registers of the worker's lanes, indexed by lane / worker count.
+            */
+            std::vector<std::unique_ptr<CheckoutRegister>> registers;
+
+            /**
+             * The number of commands submitted to the worker, only written by the submitting thread.
+            */
+            size_t submitted;
+
+            /**
+             * The number of commands the worker has finished.
+            */
+            std::atomic<size_t> processed;
+
+            /**
+             * The latency in nanoseconds from submission to completion of every command, if tracked.
+            */
+            std::vector<std::uint64_t> latencies;
+
+            /**
+             * The thread.
+            */
+            std::thread thread;
+
+            Worker(size_t queueCapacity) : queue(queueCapacity), submitted(0), processed(0) {}
+        };
+
+        /**
+         * The manager publishing catalog versions to the lanes.
+        */
+        CatalogManager& catalogManager;
+
+        /**
+         * The number of lanes.
+        */
+        int laneCount;
+
+        /**
+         * The workers.
+        */
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        /**
+         * The output stream for lane responses.
+        */
+        std::ostream& out;
+
+        /**
+         * Serializes writes of whole responses to the output stream.
+        */
+        std::mutex outMutex;
+
+        /**
+         * Whether workers record the latency of every command.
+        */
+        bool isTrackingLatency;
+
+        /**
+         * Set to stop the workers once their queues are empty.
+        */
+        std::atomic<bool> isStopping;
+
+        /**
+         * The journal of every lane, or nullptr if lanes are not journaled.
+        */
+        std::unique_ptr<Journal> journal;
+
+        /**
+         * Runs commands from a worker's queue until the server stops.
+         * @param worker The worker.
+        */
+        void runWorker(Worker& worker);
+
+        /**
+         * Writes a response of a lane to the output stream.
+         * @param lane The lane.
+         * @param response The response.
+        */
+        void writeResponse(int lane, const std::string& response);
+
+    public:
+        /**
+         * Instantiates a store and starts its workers.
+         * @param catalogManager The manager publishing catalog versions to all lanes.
+         * @param laneCount The number of lanes.
+         * @param out The output stream for lane responses.
+         * @param threadCount The number of worker threads, or 0 to use one per core (at most one per lane).
+         * @param isTrackingLatency Whether to record the latency of every command.
+        */
+        StoreServer(CatalogManager& catalogManager, int laneCount, std::ostream& out = std::cout, unsigned int threadCount = 0,
+                    bool isTrackingLatency = false);
+
+        /**
+         * Finishes all submitted commands and stops the workers.
+        */
+        ~StoreServer();
+
+        /**
+         * Recovers the open carts of the lanes from a journal file, and journals every lane from now
+         * on, with lane numbers as register ids. Call before submitting any commands.
+         * @param filepath The path of the journal file, which may not exist yet.
+        */
+        void openJournal(const std::string& filepath);
+
+        /**
+         * Gets the number of lanes.
+         * @returns The number of lanes.
+        */
+        int getLaneCount() const;
+
+        /**
+         * Queues a command for a lane. Commands of a lane run in the order they are submitted.
+         * Only one thread may submit commands.
+         * @param lane The lane, from 0 to the lane count minus 1.
+         * @param command The command, in the same format as interactive input.
+        */
+        void submit(int lane, std::string command);
+
+        /**
+         * Waits until every submitted command has finished.
+        */
+        void drain();
+
+        /**
+         * Finishes all submitted commands and stops the workers.
+        */
+        void stop();
+
+        /**
+         * Reads lines in the format `<lane> <command>` from an input stream and runs each command on
+         * its lane until the end of the stream, then waits for all commands to finish.
+         * @param in The input stream.
+        */
+        void run(std::istream& in);
+
+        /**
+         * Gets the latency of every finished command. Only valid after drain() and if latency is tracked.
+         * @returns The latencies in nanoseconds, in no particular order.
+        */
+        std::vector<std::uint64_t> getLatencies() const;
+
+        /**
+         * Runs a single command of a lane.
+         * @param catalogManager The manager publishing catalog versions, reloaded by the `reload` command.
+         * @param checkoutRegister The register of the lane.
+         * @param command The command: `<item> <quantity>`, `remove <item>`, `cart`, `items`, `deals`,
+         * `cancel`, `checkout` or `reload`.
+         * @returns The response, empty for successful scans and removals.
+        */
+        static std::string handleCommand(CatalogManager& catalogManager, CheckoutRegister& checkoutRegister, std::string command);
+
+        /**
+         * Serves lanes over a local Unix socket, one lane per connection, until the process exits.
+         * Each connection sends commands one per line and receives the response of each command,
+         * or "OK" for successful scans and removals.
+         * Each connection is served by its own thread with its own register.
+         * @param catalogManager The manager publishing catalog versions to all lanes.
+         * @param socketPath The filesystem path of the socket.
+        */
+        static void serveUnixSocket(CatalogManager& catalogManager, const std::string& socketPath);
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef TEXT_RECEIPT_SINK_H
+#define TEXT_RECEIPT_SINK_H
+
+#include "receipt_sink.h"
+#include "receipt_writer.h"
+
+/**
+ * Writes human readable receipts, each with a single write.
+*/
+class TextReceiptSink : public ReceiptSink {
+    private:
+        /**
+         * The output stream.
+        */
+        std::ostream& out;
+
+        /**
+         * Formats each receipt, reused so its buffer is only allocated once.
+        */
+        ReceiptWriter writer;
+
+    public:
+        /**
+         * Instantiates a sink.
+         * @param out The output stream, which must outlive the sink.
+        */
+        explicit TextReceiptSink(std::ostream& out);
+
+        void write(const Receipt& receipt) override;
+
+        /**
+         * Formats a receipt as text.
+         * @param receipt The receipt.
+         * @param writer The writer to append the text to.
+        */
+        static void format(const Receipt& receipt, ReceiptWriter& writer);
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "batch_checkout.h"
+#include "checkout_register.h"
+#include "io_helper.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+
+namespace {
+    /**
+     * Number of carts claimed by a worker at a time. Large enough to keep contention on the
+     * shared cart counter low, small enough to balance uneven cart sizes across workers.
+    */
+    const size_t cartsPerChunk = 16;
+}
+
+BatchCheckout::BatchCheckout(const Catalog& catalog, unsigned int threadCount, ReceiptFormat format) : catalog(catalog),
+    threadCount(threadCount), format(format) {
+    if (this->threadCount == 0) {
+        this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void BatchCheckout::readCartsFromFile(const std::string& filepath) {
+    // Open file
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: '" + filepath + "'. Please ensure it exists.");
+    }
+
+    // Maps cart ids to their index in the carts vector
+    std::unordered_map<int, size_t> indexOfCart;
+
+    std::string line;
+
+    // Skip first line
+    std::getline(file, line);
+
+    // Iterate over lines in file and add them to their carts
+    while (std::getline(file, line)) {
+        std::string_view cartIdStr, itemName, quantityStr;
+        size_t pos = 0;
+        IOHelper::nextField(line, pos, ',', cartIdStr);
+        IOHelper::nextField(line, pos, ',', itemName);
+        IOHelper::nextField(line, pos, ',', quantityStr);
+
+        // Parse cart id
+        int cartId;
+        if (IOHelper::parseInt(cartIdStr, cartId) != IOHelper::ParseStatus::Ok) {
+            throw std::runtime_error("Invalid cart id: '" + std::string(cartIdStr) + "' in file: '" + filepath + "'.");
+        }
+
+        // Get cart, creating it if this is its first line
+        auto it = indexOfCart.find(cartId);
+        if (it == indexOfCart.end()) {
+            it = indexOfCart.emplace(cartId, carts.size()).first;
+            carts.emplace_back();
+            carts.back().id = cartId;
+        }
+        Cart& cart = carts[it->second];
+
+        // Skip remaining lines of carts that are already invalid
+        if (!cart.error.empty()) {
+            continue;
+        }
+
+        // Try parsing quantity and converting to int
+        int quantity = 0;
+        if (IOHelper::parseInt(quantityStr, quantity) != IOHelper::ParseStatus::Ok) {
+            cart.error = "Invalid quantity for item: '" + std::string(itemName) + "' in file: '" + filepath + "'.";
+            continue;
+        }
+        cart.lines.emplace_back(itemName, quantity);
+    }
+
+    // Order carts by id so receipts are deterministic
+    std::sort(carts.begin(), carts.end(), [](const Cart& cart1, const Cart& cart2) {
+        return cart1.id < cart2.id;
+    });
+}
+
+void BatchCheckout::checkOutCarts(std::atomic<size_t>& nextCart) {
+    CheckoutRegister checkoutRegister(catalog);
+    std::ostringstream receiptStream;
+    std::unique_ptr<ReceiptSink> sink = ReceiptSink::create(format, receiptStream);
+    std::vector<ScanEntry> entries;
+    std::vector<ScanStatus> statuses;
+
+    while (true) {
+        // Claim the next chunk of carts
+        size_t begin = nextCart.fetch_add(cartsPerChunk);
+        if (begin >= carts.size()) {
+            return;
+        }
+        size_t end = std::min(begin + cartsPerChunk, carts.size());
+
+        for (size_t i = begin; i < end; ++i) {
+            Cart& cart = carts[i];
+            if (!cart.error.empty()) {
+                continue;
+            }
+
+            try {
+                // Scan items as a single batch
+                entries.clear();
+                for (const auto& [itemName, quantity] : cart.lines) {
+                    entries.push_back({itemName, -1, quantity});
+                }
+                statuses.resize(entries.size());
+                if (checkoutRegister.scanBatch(entries.data(), entries.size(), statuses.data()) > 0) {
+                    // Report the first entry that could not be scanned, and abandon the cart
+                    size_t failed = std::find_if(statuses.begin(), statuses.end(), [](ScanStatus status) {
+                        return status != ScanStatus::Ok;
+                    }) - statuses.begin();
+                    cart.error = CheckoutRegister::scanErrorMessage(entries[failed], statuses[failed]);
+                    checkoutRegister.clearSession();
+                    continue;
+                }
+
+                // Format receipt into the cart, so formatting runs in parallel across workers
+                receiptStream.str("");
+                checkoutRegister.checkOut(*sink, cart.id);
+                cart.receipt = receiptStream.str();
+            } catch (const std::runtime_error& e) {
+                cart.error = e.what();
+                checkoutRegister.clearSession();
+            }
+        }
+    }
+}
+
+void BatchCheckout::checkOut() {
+    std::atomic<size_t> nextCart(0);
+
+    // Start workers, using the calling thread as the last worker
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&BatchCheckout::checkOutCarts, this, std::ref(nextCart));
+    }
+    checkOutCarts(nextCart);
+
+    // Wait for all workers to finish
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int BatchCheckout::printReceipts(std::ostream& out) const {
+    int failedCarts = 0;
+    for (const Cart& cart : carts) {
+        if (!cart.error.empty()) {
+            std::cerr << "Error: Cart " << cart.id << ": " << cart.error << std::endl;
+            failedCarts++;
+            continue;
+        }
+        if (format == ReceiptFormat::Text) {
+            out << "Cart " << cart.id << std::endl;
+        }
+        out << cart.receipt;
+    }
+    return failedCarts;
+}
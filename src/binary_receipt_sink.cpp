@@ -0,0 +1,70 @@
+#include "binary_receipt_sink.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+    /**
+     * Appends an unsigned integer in little endian byte order.
+     * @param buffer The buffer.
+     * @param value The integer.
+     * @param bytes The number of bytes to write.
+    */
+    void appendInteger(std::string& buffer, std::uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    /**
+     * Appends a receipt line.
+     * @param buffer The buffer.
+     * @param line The line.
+    */
+    void appendLine(std::string& buffer, const ReceiptLine& line) {
+        // Names longer than a u16 length are truncated
+        size_t nameLength = std::min<size_t>(line.name.size(), 0xFFFF);
+        appendInteger(buffer, nameLength, 2);
+        buffer.append(line.name.data(), nameLength);
+        appendInteger(buffer, static_cast<std::uint32_t>(line.quantity), 4);
+        appendInteger(buffer, static_cast<std::uint64_t>(line.price.getCents()), 8);
+        appendInteger(buffer, static_cast<std::uint32_t>(line.dealGroup), 4);
+        appendInteger(buffer, line.isFree ? 1 : 0, 1);
+    }
+}
+
+BinaryReceiptSink::BinaryReceiptSink(std::ostream& out) : out(out) {}
+
+void BinaryReceiptSink::write(const Receipt& receipt) {
+    // Reserve the length prefix, filled in once the record is encoded
+    buffer.clear();
+    appendInteger(buffer, 0, 4);
+
+    appendInteger(buffer, recordVersion, 1);
+    appendInteger(buffer, static_cast<std::uint32_t>(receipt.cartId), 4);
+    appendInteger(buffer, static_cast<std::uint64_t>(receipt.time), 8);
+    appendInteger(buffer, static_cast<std::uint64_t>(receipt.savings.getCents()), 8);
+    appendInteger(buffer, static_cast<std::uint64_t>(receipt.total.getCents()), 8);
+    appendInteger(buffer, receipt.dealGroups.size(), 4);
+    for (const ReceiptDealGroup& group : receipt.dealGroups) {
+        appendInteger(buffer, static_cast<std::uint64_t>(group.price.getCents()), 8);
+        appendInteger(buffer, static_cast<std::uint64_t>(group.savings.getCents()), 8);
+        appendInteger(buffer, group.isBundle ? 1 : 0, 1);
+    }
+    appendInteger(buffer, receipt.dealLines.size(), 4);
+    for (const ReceiptLine& line : receipt.dealLines) {
+        appendLine(buffer, line);
+    }
+    appendInteger(buffer, receipt.items.size(), 4);
+    for (const ReceiptLine& line : receipt.items) {
+        appendLine(buffer, line);
+    }
+
+    // Fill in the length of the record after the prefix
+    std::uint64_t length = buffer.size() - 4;
+    for (int i = 0; i < 4; i++) {
+        buffer[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+}
@@ -1,244 +1,943 @@
 #include "catalog.h"
 #include "io_helper.h"
+#include "mapped_file.h"
+#include "checkout_stats.h"
+#include "receipt_writer.h"
 
 #include <iostream>
-#include <iomanip>
-#include <fstream>
-#include <sstream>
+#include <cstring>
+#include <cctype>
+#include <exception>
 #include <algorithm>
+#include <numeric>
+#include <thread>
 
-const std::unordered_set<std::string> Catalog::reservedNames = {
+const std::unordered_set<std::string_view> Catalog::reservedNames = {
     "Remove", "Cart", "Items", "Deals", "Checkout", "Options"
 };
 
-void Catalog::addItem(const std::string& name, double price) {
-    // Check if the name is in reserved names
-    if (reservedNames.find(name) != reservedNames.end()) {
-        throw std::runtime_error("Item name '" + name + "' is reserved and cannot be added to the catalog.");
+namespace {
+    /**
+     * The smallest number of bytes of a file given to each thread reading it, so small files are
+     * read by the calling thread alone.
+    */
+    const size_t minChunkBytes = 256 * 1024;
+
+    /**
+     * An item read from a line of an items file.
+    */
+    struct ParsedItem {
+        /**
+         * The length of the item name in Camel Case, which follows the name of the previous item
+         * in the chunk's names.
+        */
+        size_t nameLength;
+
+        /**
+         * The item price.
+        */
+        Money price;
+
+        /**
+         * The hash of the item name.
+        */
+        std::uint64_t hash;
+    };
+
+    /**
+     * The items read from a chunk of an items file.
+    */
+    struct ItemChunk {
+        /**
+         * The names of the chunk's items, concatenated, until they are added to the catalog.
+        */
+        std::string names;
+
+        /**
+         * The items of the lines before the first error, in file order.
+        */
+        std::vector<ParsedItem> items;
+
+        /**
+         * The error of the first line that could not be read, if any.
+        */
+        std::exception_ptr error;
+    };
+
+    /**
+     * The deals read from a chunk of a deals file.
+    */
+    struct DealChunk {
+        /**
+         * The terms of the deals of the lines before the first error, in file order.
+        */
+        std::vector<DealTerms> terms;
+
+        /**
+         * The number of items of each deal, parallel to terms.
+        */
+        std::vector<size_t> sizes;
+
+        /**
+         * The item ids of all deals, each deal ordered highest to lowest by price.
+        */
+        std::vector<int> itemIds;
+
+        /**
+         * The number of units of each deal item in a group, parallel to itemIds.
+        */
+        std::vector<int> itemCounts;
+
+        /**
+         * The error of the first line that could not be read, if any.
+        */
+        std::exception_ptr error;
+    };
+
+    /**
+     * Gets the number of chunks to split a file into, one per thread.
+     * @param bytes The size of the file's lines in bytes.
+     * @param threadCount The number of threads to use, or 0 to use one per core.
+     * @returns The number of chunks, at least 1.
+    */
+    size_t countChunks(size_t bytes, unsigned int threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        return std::max<size_t>(1, std::min<size_t>(threadCount, bytes / minChunkBytes));
+    }
+
+    /**
+     * Splits lines into chunks of about equal size, moving each split past the end of its line so
+     * every chunk holds whole lines. Reading the chunks in order with IOHelper::nextField gives the same lines
+     * as reading all the lines at once.
+     * @param lines The lines.
+     * @param chunkCount The number of chunks.
+     * @returns The chunks, some of which may be empty.
+    */
+    std::vector<std::string_view> splitLineChunks(std::string_view lines, size_t chunkCount) {
+        std::vector<std::string_view> chunks;
+        size_t start = 0;
+        for (size_t i = 1; i <= chunkCount; ++i) {
+            size_t end = lines.size();
+            if (i < chunkCount) {
+                end = std::max(start, lines.size() / chunkCount * i);
+                end = lines.find('\n', end);
+                end = end == std::string_view::npos ? lines.size() : end + 1;
+            }
+            chunks.push_back(lines.substr(start, end - start));
+            start = end;
+        }
+        return chunks;
+    }
+
+    /**
+     * Calls a function for each chunk of a file, each on its own thread. The first chunk is read
+     * by the calling thread, along with any chunks whose thread could not be started.
+     * @param chunkCount The number of chunks.
+     * @param readChunk The function, called with the index of a chunk. It must not throw.
+    */
+    template <typename Function>
+    void forEachChunk(size_t chunkCount, Function readChunk) {
+        std::vector<std::thread> workers;
+        workers.reserve(chunkCount);
+
+        // Stop starting threads at the first one that fails, so the threads already started are
+        // still joined below instead of being destroyed while running
+        size_t startedCount = 1;
+        for (; startedCount < chunkCount; ++startedCount) {
+            try {
+                workers.emplace_back(readChunk, startedCount);
+            } catch (const std::exception&) {
+                break;
+            }
+        }
+        readChunk(0);
+        for (size_t i = startedCount; i < chunkCount; ++i) {
+            readChunk(i);
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * Splits a string into words separated by whitespace.
+     * @param str The string.
+     * @param words Set to the words, of which at most maxWords are read.
+     * @param maxWords The size of words.
+     * @returns The number of words, or maxWords + 1 if there are more words than fit.
+    */
+    int splitWords(std::string_view str, std::string_view* words, int maxWords) {
+        int count = 0;
+        size_t pos = 0;
+        std::string_view word;
+        while (IOHelper::nextWord(str, pos, word)) {
+            if (count == maxWords) {
+                return maxWords + 1;
+            }
+            words[count++] = word;
+        }
+        return count;
+    }
+
+    /**
+     * Compares a word to a lowercase keyword, ignoring case.
+     * @param word The word.
+     * @param keyword The lowercase keyword.
+     * @returns Whether the word is the keyword.
+    */
+    bool isKeyword(std::string_view word, std::string_view keyword) {
+        if (word.size() != keyword.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < word.size(); ++i) {
+            if (std::tolower(static_cast<unsigned char>(word[i])) != keyword[i]) {
+                return false;
+            }
+        }
+        return true;
     }
 
+    /**
+     * Parses a count of units in a deal group.
+     * @param str The input string.
+     * @param count Set to the count if parsing succeeds.
+     * @returns Whether the string is a whole number from 1 to Deal::maxGroupSize.
+    */
+    bool parseGroupCount(std::string_view str, int& count) {
+        if (str.empty() || str.size() > 2) {
+            return false;
+        }
+        count = 0;
+        for (char c : str) {
+            if (!std::isdigit(static_cast<unsigned char>(c))) {
+                return false;
+            }
+            count = count * 10 + (c - '0');
+        }
+        return count >= 1 && count <= Deal::maxGroupSize;
+    }
+
+    /**
+     * Reads the terms of a deal, `Buy N Get M` or `Bundle <price>`, ignoring case.
+     * @param terms The terms.
+     * @param deal Set to the terms if they are valid.
+     * @returns Whether the terms are valid.
+    */
+    bool parseDealTerms(std::string_view terms, DealTerms& deal) {
+        std::string_view words[4];
+        int count = splitWords(terms, words, 4);
+        if (count == 4 && isKeyword(words[0], "buy") && isKeyword(words[2], "get")) {
+            deal.type = DealType::BuyGetFree;
+            return parseGroupCount(words[1], deal.buyCount) && parseGroupCount(words[3], deal.freeCount)
+                && deal.buyCount + deal.freeCount <= Deal::maxGroupSize;
+        }
+        if (count == 2 && isKeyword(words[0], "bundle")) {
+            deal.type = DealType::Bundle;
+            std::string_view price = words[1];
+            if (!price.empty() && price[0] == '$') {
+                price.remove_prefix(1);
+            }
+            return Money::parse(price, deal.bundlePrice) && deal.bundlePrice >= Money();
+        }
+        return false;
+    }
+
+    /**
+     * Gets the memory reserved by a column.
+     * @param column The column.
+     * @returns The size in bytes.
+    */
+    template <typename T>
+    size_t columnBytes(const std::vector<T>& column) {
+        return column.capacity() * sizeof(T);
+    }
+}
+
+Catalog::Catalog() : namePool(nullptr), nameOffsets(1, 0), dealOffsets(1, 0), clusterDealOffsets(1, 0),
+    clusterItemOffsets(1, 0), loadThreadCount(0) {
+    reserveIndex(0);
+}
+
+void Catalog::addItem(std::uint64_t nameEnd, Money price, std::uint64_t hash) {
     // Check if item already exists in catalog
-    if (itemIdMap.find(name) != itemIdMap.end()) {
-        throw std::runtime_error("Item '" + name + "' already exists in the catalog.");
+    std::string_view name(namePool + nameOffsets.back(), nameEnd - nameOffsets.back());
+    size_t slot = findIndexSlot(name, hash);
+    if (itemIndex[slot].itemId != -1) {
+        throw std::runtime_error("Item '" + std::string(name) + "' already exists in the catalog.");
     }
 
-    // Map item name to index in items vector (index also serves as item id), and add item to vector
-    int id = items.size();
-    items.emplace_back(name, price);
-    itemIdMap[name] = id;
+    // Add item to the end of each column (its row also serves as item id), and map its name to it
+    int id = itemPrices.size();
+    nameOffsets.push_back(nameEnd);
+    itemPrices.push_back(price.getCents());
+    itemDealClusterIds.push_back(-1);
+    itemIndex[slot] = {static_cast<std::uint32_t>(hash >> 32), id};
+
+    // Grow index once it is more than half full
+    if (itemPrices.size() * 2 > itemIndex.size()) {
+        reserveIndex(itemPrices.size() * 2);
+    }
 }
 
-void Catalog::addDeal(const std::string& names) {
+void Catalog::parseDeal(std::string_view line, DealTerms& deal, std::vector<int>& itemIds, std::vector<int>& itemCounts) const {
     // Check that string is not empty
-    if (names.empty()) {
+    if (line.empty()) {
         throw std::runtime_error("Empty deals may not be added to the catalog.");
     }
 
-    // Get id for this deal (will be index into deals Vector)
-    int dealId = deals.size();
-
-    // Initialize new deal
-    deals.emplace_back();
-    std::vector<int>& deal = deals.back();
+    // Initialize new deal, which is Buy 2 Get 1 unless the line starts with other terms
+    deal = DealTerms();
+    itemIds.clear();
+    itemCounts.clear();
+
+    // Read the deal terms before a colon. Anything other than terms is part of an item name.
+    std::string_view names = line;
+    size_t colon = line.find(':');
+    if (colon != std::string_view::npos) {
+        std::string_view terms = line.substr(0, colon);
+        std::string_view firstWord;
+        splitWords(terms, &firstWord, 1);
+        if (isKeyword(firstWord, "buy") || isKeyword(firstWord, "bundle")) {
+            if (!parseDealTerms(terms, deal)) {
+                throw std::runtime_error("Invalid terms '" + std::string(terms) + "' for deal: '" + std::string(line)
+                    + "'. Terms must be 'Buy N Get M' or 'Bundle <price>', with at most "
+                    + std::to_string(Deal::maxGroupSize) + " units in a deal group.");
+            }
+            names = line.substr(colon + 1);
+            while (!names.empty() && std::isspace(static_cast<unsigned char>(names[0]))) {
+                names.remove_prefix(1);
+            }
+            if (names.empty()) {
+                throw std::runtime_error("Empty deals may not be added to the catalog.");
+            }
+        }
+    }
+    bool isBundle = deal.type == DealType::Bundle;
 
-    // Iterate over item names separated by commas
-    std::stringstream ss(names);
+    // Iterate over item names separated by commas, ignoring a trailing comma like std::getline
     std::string itemName;
-    while (std::getline(ss, itemName, ',')) {
+    std::string_view nameField;
+    size_t pos = 0;
+    while (IOHelper::nextField(names, pos, ',', nameField)) {
+        itemName.assign(nameField);
+
         // Convert item name to Camel Case
         IOHelper::toCamelCase(itemName);
 
-        // Lookup item name in map to retrieve item id
-        auto it = itemIdMap.find(itemName);
-        if (it == itemIdMap.end()) {
+        // Lookup item name in index to retrieve item id
+        int itemId = getItemId(itemName);
+        if (itemId == -1) {
             throw std::runtime_error("Item '" + itemName + "' does not exist in the catalog and may not be included in deals.");
         }
 
-        // Get item object
-        const CatalogItem& item = items[it->second];
-
-        // Check if item is already in a deal
-        if (item.dealId != -1) {
-            throw std::runtime_error("Item '" + itemName + "' is already included in a deal and may not be included again.");
+        // Bundles may list an item several times to include several units of it,
+        // but other deals already allow any number of units of each item
+        auto listed = std::find(itemIds.begin(), itemIds.end(), itemId);
+        if (listed != itemIds.end()) {
+            if (!isBundle) {
+                throw std::runtime_error("Item '" + itemName + "' is listed more than once in the same deal.");
+            }
+            itemCounts[listed - itemIds.begin()]++;
+            continue;
         }
 
-        // Set deal id on item objet
-        items[it->second].dealId = dealId;
+        // Add item ID to deal set, with a single unit in each group unless it is listed again
+        itemIds.push_back(itemId);
+        itemCounts.push_back(1);
+    }
 
-        // Add item ID to deal set
-        deal.push_back(it->second);
+    if (!isBundle) {
+        // Sort items within deal by price (highest to lowest)
+        std::sort(itemIds.begin(), itemIds.end(), [this](int id1, int id2) {
+            return itemPrices[id1] > itemPrices[id2];
+        });
+        return;
     }
 
-    // Sort items within deal by price (highest to lowest)
-    std::sort(deal.begin(), deal.end(), [this](int id1, int id2) {
-        return items[id1].price > items[id2].price;
+    // Sort bundle items by price together with their counts, and check the bundle saves money
+    std::vector<int> order(itemIds.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this, &itemIds](int i, int j) {
+        return itemPrices[itemIds[i]] > itemPrices[itemIds[j]];
     });
+    std::vector<int> sortedIds(order.size());
+    std::vector<int> sortedCounts(order.size());
+    Money fullPrice;
+    int groupSize = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        sortedIds[i] = itemIds[order[i]];
+        sortedCounts[i] = itemCounts[order[i]];
+        fullPrice += Money(itemPrices[sortedIds[i]]) * sortedCounts[i];
+        groupSize += sortedCounts[i];
+    }
+    itemIds.swap(sortedIds);
+    itemCounts.swap(sortedCounts);
+    if (groupSize > Deal::maxGroupSize) {
+        throw std::runtime_error("Bundle: '" + std::string(line) + "' may include at most "
+            + std::to_string(Deal::maxGroupSize) + " units.");
+    }
+    if (deal.bundlePrice >= fullPrice) {
+        throw std::runtime_error("Bundle: '" + std::string(line) + "' must cost less than its items cost separately.");
+    }
+}
+
+void Catalog::buildDealClusters() {
+    // Union deals that share an item, tracking the first deal of each item
+    size_t dealCount = dealTerms.size();
+    size_t itemCount = itemPrices.size();
+    std::vector<int> parent(dealCount);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](int dealId) {
+        while (parent[dealId] != dealId) {
+            parent[dealId] = parent[parent[dealId]];
+            dealId = parent[dealId];
+        }
+        return dealId;
+    };
+    std::vector<int> firstDealOfItem(itemCount, -1);
+    for (size_t dealId = 0; dealId < dealCount; ++dealId) {
+        for (std::uint64_t i = dealOffsets[dealId]; i < dealOffsets[dealId + 1]; ++i) {
+            int itemId = dealItemIds[i];
+            if (firstDealOfItem[itemId] == -1) {
+                firstDealOfItem[itemId] = dealId;
+            } else {
+                int root1 = find(firstDealOfItem[itemId]);
+                int root2 = find(dealId);
+                parent[std::max(root1, root2)] = std::min(root1, root2);
+            }
+        }
+    }
+
+    // Number clusters in the order of their first deal, and count their deals
+    std::vector<int> clusterOfRoot(dealCount, -1);
+    std::vector<int> clusterOfDeal(dealCount);
+    std::vector<std::uint64_t> newDealOffsets(1, 0);
+    for (size_t dealId = 0; dealId < dealCount; ++dealId) {
+        int root = find(dealId);
+        if (clusterOfRoot[root] == -1) {
+            clusterOfRoot[root] = newDealOffsets.size() - 1;
+            newDealOffsets.push_back(0);
+        }
+        clusterOfDeal[dealId] = clusterOfRoot[root];
+        newDealOffsets[clusterOfDeal[dealId] + 1]++;
+    }
+    size_t clusterCount = newDealOffsets.size() - 1;
+
+    // Set the cluster of every item, counting the items of each cluster and keeping the order
+    // they first appear in
+    std::fill(itemDealClusterIds.begin(), itemDealClusterIds.end(), -1);
+    std::vector<std::uint64_t> newItemOffsets(clusterCount + 1, 0);
+    std::vector<int> itemsInOrder;
+    for (size_t dealId = 0; dealId < dealCount; ++dealId) {
+        for (std::uint64_t i = dealOffsets[dealId]; i < dealOffsets[dealId + 1]; ++i) {
+            int itemId = dealItemIds[i];
+            if (itemDealClusterIds[itemId] == -1) {
+                itemDealClusterIds[itemId] = clusterOfDeal[dealId];
+                newItemOffsets[clusterOfDeal[dealId] + 1]++;
+                itemsInOrder.push_back(itemId);
+            }
+        }
+    }
+
+    // Place the deals and items of each cluster in its rows, keeping their order
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        newDealOffsets[cluster + 1] += newDealOffsets[cluster];
+        newItemOffsets[cluster + 1] += newItemOffsets[cluster];
+    }
+    std::vector<int> newDealIds(dealCount);
+    std::vector<std::uint64_t> cursors(newDealOffsets.begin(), newDealOffsets.end() - 1);
+    for (size_t dealId = 0; dealId < dealCount; ++dealId) {
+        newDealIds[cursors[clusterOfDeal[dealId]]++] = dealId;
+    }
+    std::vector<int> newItemIds(itemsInOrder.size());
+    cursors.assign(newItemOffsets.begin(), newItemOffsets.end() - 1);
+    for (int itemId : itemsInOrder) {
+        newItemIds[cursors[itemDealClusterIds[itemId]]++] = itemId;
+    }
+
+    // Order the items of each cluster by price, and find the position of each deal item within them
+    std::vector<int> slotOfItem(itemCount, -1);
+    std::vector<int> newSlots(dealItemIds.size());
+    std::vector<int> newSlotCounts(dealItemIds.size());
+    std::vector<std::pair<int, int>> slots;
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster) {
+        auto first = newItemIds.begin() + newItemOffsets[cluster];
+        auto last = newItemIds.begin() + newItemOffsets[cluster + 1];
+        std::stable_sort(first, last, [this](int id1, int id2) {
+            return itemPrices[id1] > itemPrices[id2];
+        });
+        for (auto item = first; item != last; ++item) {
+            slotOfItem[*item] = item - first;
+        }
+
+        for (std::uint64_t i = newDealOffsets[cluster]; i < newDealOffsets[cluster + 1]; ++i) {
+            int dealId = newDealIds[i];
+            slots.clear();
+            for (std::uint64_t j = dealOffsets[dealId]; j < dealOffsets[dealId + 1]; ++j) {
+                slots.emplace_back(slotOfItem[dealItemIds[j]], dealItemCounts[j]);
+            }
+            std::sort(slots.begin(), slots.end());
+            for (size_t j = 0; j < slots.size(); ++j) {
+                newSlots[dealOffsets[dealId] + j] = slots[j].first;
+                newSlotCounts[dealOffsets[dealId] + j] = slots[j].second;
+            }
+        }
+    }
+    clusterDealOffsets.swap(newDealOffsets);
+    clusterDealIds.swap(newDealIds);
+    clusterItemOffsets.swap(newItemOffsets);
+    clusterItemIds.swap(newItemIds);
+    dealSlots.swap(newSlots);
+    dealSlotCounts.swap(newSlotCounts);
 }
 
-int Catalog::getItemId(const std::string& itemName) const {
-    auto it = itemIdMap.find(itemName);
-    if (it == itemIdMap.end()) {
-        return -1;
+std::uint64_t Catalog::hashName(std::string_view name) {
+    // 64 bit FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
     }
+    return hash;
+}
+
+size_t Catalog::findIndexSlot(std::string_view name, std::uint64_t hash) const {
+    // Linearly probe from the name's home slot until finding the name or an empty slot,
+    // only comparing names of slots with a matching tag
+    size_t mask = itemIndex.size() - 1;
+    size_t slot = hash & mask;
+    std::uint32_t tag = hash >> 32;
+    while (true) {
+        const IndexSlot& indexSlot = itemIndex[slot];
+        if (indexSlot.itemId == -1 || (indexSlot.tag == tag && itemName(indexSlot.itemId) == name)) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
 
-    // Return item
-    return it->second;
+void Catalog::reserveIndex(size_t itemCount) {
+    // Find smallest power of 2 capacity that keeps the index at most half full
+    size_t capacity = 16;
+    while (capacity < itemCount * 2) {
+        capacity *= 2;
+    }
+    if (capacity <= itemIndex.size()) {
+        return;
+    }
+
+    // Reinsert all items
+    itemIndex.assign(capacity, {0, -1});
+    for (size_t id = 0; id < itemPrices.size(); ++id) {
+        std::string_view name = itemName(id);
+        std::uint64_t hash = hashName(name);
+        itemIndex[findIndexSlot(name, hash)] = {static_cast<std::uint32_t>(hash >> 32), static_cast<std::int32_t>(id)};
+    }
+}
+
+int Catalog::getItemId(std::string_view itemName) const {
+    // Return item id, or -1 if the slot is empty
+    return itemIndex[findIndexSlot(itemName, hashName(itemName))].itemId;
+}
+
+void Catalog::getItemIds(const std::string_view* itemNames, size_t count, int* itemIds) const {
+    // Hash a block of names and prefetch their home slots before probing any of them, so the
+    // slots are loaded from memory in parallel
+    const size_t blockSize = 16;
+    std::uint64_t hashes[blockSize];
+    size_t mask = itemIndex.size() - 1;
+    for (size_t block = 0; block < count; block += blockSize) {
+        size_t blockEnd = std::min(count, block + blockSize);
+        for (size_t i = block; i < blockEnd; ++i) {
+            hashes[i - block] = hashName(itemNames[i]);
+#ifdef __GNUC__
+            __builtin_prefetch(&itemIndex[hashes[i - block] & mask]);
+#endif
+        }
+        for (size_t i = block; i < blockEnd; ++i) {
+            itemIds[i] = itemIndex[findIndexSlot(itemNames[i], hashes[i - block])].itemId;
+        }
+    }
 }
 
-const CatalogItem& Catalog::getItem(int itemId) const {
-    if (itemId < 0 || itemId > items.size()) {
+CatalogItem Catalog::getItem(int itemId) const {
+    if (itemId < 0 || itemId >= getItemCount()) {
         throw std::runtime_error("Error: Item with id '" + std::to_string(itemId) + "' does not exist."); 
     };
 
-    // Return item
-    return items[itemId];
+    // Gather item from its columns
+    return {itemName(itemId), Money(itemPrices[itemId]), itemDealClusterIds[itemId]};
 }
 
-const std::vector<int>& Catalog::getDeal(int dealId) const {
-    if (dealId < 0 || dealId > deals.size()) {
+const std::int64_t* Catalog::getItemPrices() const {
+    return itemPrices.data();
+}
+
+Deal Catalog::getDeal(int dealId) const {
+    if (dealId < 0 || dealId >= getDealCount()) {
         throw std::runtime_error("Error: Deal with id '" + std::to_string(dealId) + "' does not exist."); 
     };
 
-    // Return item
-    return deals[dealId];
+    // Return the deal's terms with views of its row of the deal item columns
+    Deal deal;
+    static_cast<DealTerms&>(deal) = dealTerms[dealId];
+    size_t count = dealOffsets[dealId + 1] - dealOffsets[dealId];
+    deal.itemIds = {dealItemIds.data() + dealOffsets[dealId], count};
+    deal.itemCounts = {dealItemCounts.data() + dealOffsets[dealId], count};
+    return deal;
 }
 
-void Catalog::readItemsFromFile(const std::string& filepath) {
-    // Open file
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open file: '" + filepath + "'. Please ensure it exists.");
-    }
+DealCluster Catalog::getDealCluster(int clusterId) const {
+    if (clusterId < 0 || clusterId >= getDealClusterCount()) {
+        throw std::runtime_error("Error: Deal cluster with id '" + std::to_string(clusterId) + "' does not exist.");
+    };
 
-    std::string line, itemName, priceStr;
-    double itemPrice;
+    DealCluster cluster;
+    cluster.dealIds = {clusterDealIds.data() + clusterDealOffsets[clusterId],
+                       static_cast<size_t>(clusterDealOffsets[clusterId + 1] - clusterDealOffsets[clusterId])};
+    cluster.itemIds = {clusterItemIds.data() + clusterItemOffsets[clusterId],
+                       static_cast<size_t>(clusterItemOffsets[clusterId + 1] - clusterItemOffsets[clusterId])};
+    cluster.dealOffsets = dealOffsets.data();
+    cluster.slots = dealSlots.data();
+    cluster.slotCounts = dealSlotCounts.data();
+    return cluster;
+}
 
-    // Skip first line
-    std::getline(file, line);
+void Catalog::setLoadThreadCount(unsigned int threadCount) {
+    loadThreadCount = threadCount;
+}
 
-    // Iterate over lines in file
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
+int Catalog::getItemCount() const {
+    return itemPrices.size();
+}
 
-        // Read item
-        if (!std::getline(ss, itemName, ',')) { 
-            throw std::runtime_error("Cannot read an item name in file: '" + filepath +"'.");
-        }
+int Catalog::getDealCount() const {
+    return dealTerms.size();
+}
 
-        // Read price
-        if (!std::getline(ss, priceStr, ',')) {
-            throw std::runtime_error("Cannot read price for item: '" + itemName + "' in file: '" + filepath +"'.");
-        }
+int Catalog::getDealClusterCount() const {
+    return clusterDealOffsets.size() - 1;
+}
 
-        try {
-            // Convert price to double
-            itemPrice = std::stod(priceStr);
-        } catch (const std::invalid_argument& e) {
-            // Handle invalid price conversion
-            throw std::runtime_error("Invalid price for item: '" + itemName + "' in file: '" + filepath +"'.");
-        } 
+Catalog::MemoryUsage Catalog::getMemoryUsage() const {
+    MemoryUsage usage;
+
+    // Names of a snapshot are read from the mapped file rather than stored
+    usage.names = snapshotFile ? nameOffsets.back() : columnBytes(nameStorage);
+    usage.index = columnBytes(itemIndex);
+    usage.items = columnBytes(nameOffsets) + columnBytes(itemPrices) + columnBytes(itemDealClusterIds);
+    usage.deals = columnBytes(dealTerms) + columnBytes(dealOffsets) + columnBytes(dealItemIds)
+        + columnBytes(dealItemCounts) + columnBytes(dealSlots) + columnBytes(dealSlotCounts)
+        + columnBytes(clusterDealOffsets) + columnBytes(clusterDealIds) + columnBytes(clusterItemOffsets)
+        + columnBytes(clusterItemIds);
+    return usage;
+}
 
-        // Convert item name to Camel Case
-        IOHelper::toCamelCase(itemName);
+void Catalog::readItemsFromFile(const std::string& filepath) {
+    CHECKOUT_STATS_PHASE(LoadItems);
+
+    auto start = std::chrono::steady_clock::now();
 
-        addItem(itemName, itemPrice);
+    // Open file
+    MappedFile file(filepath);
+    if (!file.isOpen()) {
+        throw std::runtime_error("Cannot open file: '" + filepath + "'. Please ensure it exists.");
     }
+    std::string_view contents = file.contents();
+
+    // Skip first line, and split the remaining lines into chunks read in parallel
+    std::string_view line;
+    size_t pos = 0;
+    IOHelper::nextField(contents, pos, '\n', line);
+    std::string_view lines = contents.substr(std::min(pos, contents.size()));
+    std::vector<std::string_view> chunkLines = splitLineChunks(lines, countChunks(lines.size(), loadThreadCount));
+    std::vector<ItemChunk> chunks(chunkLines.size());
+
+    // Read the items of each chunk, stopping at the first line that cannot be read
+    forEachChunk(chunks.size(), [this, &filepath, &chunkLines, &chunks](size_t index) {
+        ItemChunk& chunk = chunks[index];
+        try {
+            // Reserve space for one item per line
+            std::string_view lines = chunkLines[index];
+            chunk.items.reserve(std::count(lines.begin(), lines.end(), '\n') + 1);
+            chunk.names.reserve(lines.size());
+
+            std::string_view line;
+            std::string_view field;
+            std::string itemName;
+            Money itemPrice;
+
+            // Iterate over lines in chunk
+            size_t pos = 0;
+            while (IOHelper::nextField(lines, pos, '\n', line)) {
+                // Read item
+                size_t fieldPos = 0;
+                if (!IOHelper::nextField(line, fieldPos, ',', field)) {
+                    throw std::runtime_error("Cannot read an item name in file: '" + filepath +"'.");
+                }
+                itemName.assign(field);
+
+                // Read price
+                std::string_view priceStr;
+                if (!IOHelper::nextField(line, fieldPos, ',', priceStr)) {
+                    throw std::runtime_error("Cannot read price for item: '" + itemName + "' in file: '" + filepath +"'.");
+                }
+
+                // Convert price to cents
+                if (!Money::parse(priceStr, itemPrice)) {
+                    // Handle invalid price conversion
+                    throw std::runtime_error("Invalid price for item: '" + itemName + "' in file: '" + filepath +"'.");
+                }
+
+                // Convert item name to Camel Case
+                IOHelper::toCamelCase(itemName);
+
+                // Check if the name is in reserved names
+                if (reservedNames.find(itemName) != reservedNames.end()) {
+                    throw std::runtime_error("Item name '" + itemName + "' is reserved and cannot be added to the catalog.");
+                }
+
+                chunk.names += itemName;
+                chunk.items.push_back({itemName.size(), itemPrice, hashName(itemName)});
+            }
+        } catch (...) {
+            chunk.error = std::current_exception();
+        }
+    });
+
+    // Copy the names of a snapshot out of the mapped file so new names can follow them, and drop
+    // the names of any items left over from a failed read
+    if (snapshotFile) {
+        nameStorage.assign(namePool, namePool + nameOffsets.back());
+        snapshotFile.reset();
+    }
+    nameStorage.resize(nameOffsets.back());
+
+    // Add the items of each chunk in file order, so item ids and errors are the same as reading the
+    // file line by line. Only checking for duplicate names depends on earlier lines.
+    size_t itemCount = itemPrices.size();
+    size_t nameBytes = nameStorage.size();
+    for (const ItemChunk& chunk : chunks) {
+        itemCount += chunk.items.size();
+        nameBytes += chunk.names.size();
+    }
+    nameStorage.reserve(nameBytes);
+    nameOffsets.reserve(itemCount + 1);
+    itemPrices.reserve(itemCount);
+    itemDealClusterIds.reserve(itemCount);
+    reserveIndex(itemCount);
+    for (ItemChunk& chunk : chunks) {
+        nameStorage.insert(nameStorage.end(), chunk.names.begin(), chunk.names.end());
+        namePool = nameStorage.data();
+        std::uint64_t nameEnd = nameOffsets.back();
+        for (const ParsedItem& item : chunk.items) {
+            nameEnd += item.nameLength;
+            addItem(nameEnd, item.price, item.hash);
+        }
+        if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+        }
+    }
+
+    recordLoad(filepath, contents.size(), start);
 }
 
 void Catalog::readDealsFromFile(const std::string& filepath) {
+    CHECKOUT_STATS_PHASE(LoadDeals);
+
+    auto start = std::chrono::steady_clock::now();
+
     // Open file
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
+    MappedFile file(filepath);
+    if (!file.isOpen()) {
         throw std::runtime_error("Cannot open file: '" + filepath + "'. Please ensure it exists.");
     }
+    std::string_view contents = file.contents();
+
+    // Skip first line, and split the remaining lines into chunks read in parallel
+    std::string_view line;
+    size_t pos = 0;
+    IOHelper::nextField(contents, pos, '\n', line);
+    std::string_view lines = contents.substr(std::min(pos, contents.size()));
+    std::vector<std::string_view> chunkLines = splitLineChunks(lines, countChunks(lines.size(), loadThreadCount));
+    std::vector<DealChunk> chunks(chunkLines.size());
+
+    // Read the deals of each chunk, stopping at the first line that cannot be read. Deals only
+    // depend on the items of the catalog, which are not changed while the chunks are read.
+    forEachChunk(chunks.size(), [this, &chunkLines, &chunks](size_t index) {
+        DealChunk& chunk = chunks[index];
+        try {
+            // Reserve space for one deal per line
+            std::string_view lines = chunkLines[index];
+            size_t lineCount = std::count(lines.begin(), lines.end(), '\n') + 1;
+            chunk.terms.reserve(lineCount);
+            chunk.sizes.reserve(lineCount);
+
+            std::string_view line;
+            DealTerms terms;
+            std::vector<int> itemIds;
+            std::vector<int> itemCounts;
+            size_t pos = 0;
+            while (IOHelper::nextField(lines, pos, '\n', line)) {
+                parseDeal(line, terms, itemIds, itemCounts);
+                chunk.terms.push_back(terms);
+                chunk.sizes.push_back(itemIds.size());
+                chunk.itemIds.insert(chunk.itemIds.end(), itemIds.begin(), itemIds.end());
+                chunk.itemCounts.insert(chunk.itemCounts.end(), itemCounts.begin(), itemCounts.end());
+            }
+        } catch (...) {
+            chunk.error = std::current_exception();
+        }
+    });
 
-    std::string line;
+    // Append the deals of each chunk to the deal columns in file order, stopping at the first error
+    size_t dealCount = dealTerms.size();
+    size_t dealItemCount = dealItemIds.size();
+    for (const DealChunk& chunk : chunks) {
+        dealCount += chunk.terms.size();
+        dealItemCount += chunk.itemIds.size();
+    }
+    dealTerms.reserve(dealCount);
+    dealOffsets.reserve(dealCount + 1);
+    dealItemIds.reserve(dealItemCount);
+    dealItemCounts.reserve(dealItemCount);
+    for (const DealChunk& chunk : chunks) {
+        for (size_t i = 0; i < chunk.terms.size(); ++i) {
+            dealTerms.push_back(chunk.terms[i]);
+            dealOffsets.push_back(dealOffsets.back() + chunk.sizes[i]);
+        }
+        dealItemIds.insert(dealItemIds.end(), chunk.itemIds.begin(), chunk.itemIds.end());
+        dealItemCounts.insert(dealItemCounts.end(), chunk.itemCounts.begin(), chunk.itemCounts.end());
+        if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+        }
+    }
+    buildDealClusters();
 
-    // Skip first line
-    std::getline(file, line);
+    recordLoad(filepath, contents.size(), start);
+}
 
-    // Iterate over lines in file and add deals
-    while (std::getline(file, line)) {
-        addDeal(line);
-    }
+void Catalog::recordLoad(const std::string& filepath, size_t bytes, std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    loadStats.push_back({filepath, bytes, elapsed.count()});
 }
 
-void Catalog::printItems() const {
+const std::vector<Catalog::LoadStats>& Catalog::getLoadStats() const {
+    return loadStats;
+}
+
+void Catalog::printItems(std::ostream& out) const {
     // Column widths
     const int nameWidth = 25;
     const int priceWidth = 15;
     const int totalWidth = nameWidth + priceWidth;
     
     // Header
-    IOHelper::printSolidLine(totalWidth);
-    IOHelper::printCentered("Supermarket Items", totalWidth);
-    IOHelper::printSolidLine(totalWidth);
+    ReceiptWriter writer(itemPrices.size() * totalWidth + 512);
+    writer.solidLine(totalWidth);
+    writer.centeredLine("Supermarket Items", totalWidth);
+    writer.solidLine(totalWidth);
 
     // Column headers
-    std::cout << std::setw(nameWidth) << std::left << "Item";
-    std::cout << std::setw(priceWidth) << std::right << "Price" << std::endl;
-    IOHelper::printDashedLine(totalWidth);
+    writer.appendLeft("Item", nameWidth);
+    writer.appendRight("Price", priceWidth);
+    writer.endLine();
+    writer.dashedLine(totalWidth);
 
     // Items
-    for (const CatalogItem& item : items) {
+    char price[Money::maxFormattedLength + 8];
+    for (int itemId = 0; itemId < getItemCount(); ++itemId) {
         // Print name
-        std::cout << std::setw(nameWidth) << std::left << item.name;
+        writer.appendLeft(itemName(itemId), nameWidth);
 
         // Print price
-        std::stringstream priceStream;
-        priceStream << "$" << std::fixed << std::setprecision(2) << item.price << " / unit";
-        std::cout << std::setw(priceWidth) << std::right << priceStream.str() << std::endl;
+        int length = Money(itemPrices[itemId]).format(price);
+        std::memcpy(price + length, " / unit", 7);
+        writer.appendRight(std::string_view(price, length + 7), priceWidth);
+        writer.endLine();
     }
-    IOHelper::printSolidLine(totalWidth);
+    writer.solidLine(totalWidth);
+    writer.writeTo(out);
+    out.flush();
 }
 
-void Catalog::printDeals() const {
+void Catalog::printDeals(std::ostream& out) const {
     // Column widths
     const int typeWidth = 6;   
     const int itemsWidth = 60;
     const int totalWidth = typeWidth + itemsWidth;
     
     // Header
-    IOHelper::printSolidLine(totalWidth);
-    IOHelper::printCentered("Supermarket Deals", totalWidth);
-    IOHelper::printSolidLine(totalWidth);
+    ReceiptWriter writer(dealTerms.size() * itemsWidth + 1024);
+    writer.solidLine(totalWidth);
+    writer.centeredLine("Supermarket Deals", totalWidth);
+    writer.solidLine(totalWidth);
 
     // Deal types
-    IOHelper::printCentered("Deal Types", totalWidth);
-    IOHelper::printDashedLine(totalWidth);
-    std::cout << "Type A: Buy 2 of this item and get a 3rd free!" << std::endl;
-    std::cout << "Type B: Buy any 3 of these items (duplicates allowed) and the" << std::endl;
-    std::cout << "        cheapest is free!" << std::endl;
-    IOHelper::printDashedLine(totalWidth);
-    IOHelper::printCentered("Active Deals", totalWidth);
-    IOHelper::printDashedLine(totalWidth);
+    writer.centeredLine("Deal Types", totalWidth);
+    writer.dashedLine(totalWidth);
+    writer.append("Type A: Buy 2 of this item and get a 3rd free!\n");
+    writer.append("Type B: Buy any 3 of these items (duplicates allowed) and the\n");
+    writer.append("        cheapest is free!\n");
+
+    // Only describe the other deal types if the catalog has any
+    bool hasBuyGetFree = false;
+    bool hasBundle = false;
+    for (const DealTerms& deal : dealTerms) {
+        hasBuyGetFree |= deal.type == DealType::BuyGetFree && !deal.isBuyTwoGetOne();
+        hasBundle |= deal.type == DealType::Bundle;
+    }
+    if (hasBuyGetFree) {
+        writer.append("Type C: Buy any N + M of these items (duplicates allowed) and\n");
+        writer.append("        the M cheapest are free!\n");
+    }
+    if (hasBundle) {
+        writer.append("Type D: Buy all of these items together for the bundle price!\n");
+    }
+    writer.dashedLine(totalWidth);
+    writer.centeredLine("Active Deals", totalWidth);
+    writer.dashedLine(totalWidth);
 
     // Column headers
-    std::cout << std::setw(typeWidth) << std::left << "Type";
-    std::cout << std::setw(itemsWidth) << std::right << "Items" << std::endl;
-    IOHelper::printDashedLine(totalWidth);
+    writer.appendLeft("Type", typeWidth);
+    writer.appendRight("Items", itemsWidth);
+    writer.endLine();
+    writer.dashedLine(totalWidth);
 
     // Deals
-    for (const auto& deal : deals) {
-        if (deal.size() > 1) {
-            std::cout << std::setw(typeWidth) << std::left << "B";
+    std::string itemNames;
+    for (int dealId = 0; dealId < getDealCount(); ++dealId) {
+        Deal deal = getDeal(dealId);
+        itemNames.clear();
+        if (deal.isBuyTwoGetOne()) {
+            writer.appendLeft(deal.itemIds.size() > 1 ? "B" : "A", typeWidth);
+        } else if (deal.type == DealType::BuyGetFree) {
+            writer.appendLeft("C", typeWidth);
+            itemNames += "Buy " + std::to_string(deal.buyCount) + " Get " + std::to_string(deal.freeCount) + ": ";
         } else {
-            std::cout << std::setw(typeWidth) << std::left << "A";
+            writer.appendLeft("D", typeWidth);
+            itemNames += deal.bundlePrice.toString() + ": ";
         }
-        
-        std::stringstream itemsStream;
-        bool first = true;
 
-        for (int id : deal) {
+        bool first = true;
+        for (size_t i = 0; i < deal.itemIds.size(); ++i) {
             if (!first) {
-                itemsStream << ", ";
+                itemNames += ", ";
+            }
+            itemNames += itemName(deal.itemIds[i]);
+            if (deal.itemCounts[i] > 1) {
+                itemNames += " (" + std::to_string(deal.itemCounts[i]) + ")";
             }
-            itemsStream << items[id].name;
             first = false;
         }
 
         // Print item names
-        std::cout << std::setw(itemsWidth) << std::right << itemsStream.str() << std::endl;
+        writer.appendRight(itemNames, itemsWidth);
+        writer.endLine();
     }
-    IOHelper::printSolidLine(totalWidth);
-}
\ No newline at end of file
+    writer.solidLine(totalWidth);
+    writer.writeTo(out);
+    out.flush();
+}
@@ -1,5 +0,0 @@
-#include "catalog_item.h"
-
-CatalogItem::CatalogItem(const std::string& name, double price) : name(name), price(price) {
-    dealId = -1;
-}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "catalog_manager.h"
+
+#include <iostream>
+#include <stdexcept>
+
+CatalogManager::CatalogManager(std::shared_ptr<const Catalog> catalog, Loader loader) : current(std::move(catalog)), version(1),
+    loader(std::move(loader)), isReloading(false) {}
+
+CatalogManager::~CatalogManager() {
+    std::lock_guard<std::mutex> lock(threadMutex);
+    if (reloadThread.joinable()) {
+        reloadThread.join();
+    }
+}
+
+std::shared_ptr<const Catalog> CatalogManager::acquire() const {
+    return std::atomic_load(&current);
+}
+
+std::uint64_t CatalogManager::getVersion() const {
+    return version.load(std::memory_order_acquire);
+}
+
+void CatalogManager::publish(std::shared_ptr<const Catalog> catalog) {
+    // Store the catalog before bumping the version, so a register that sees the new version
+    // always acquires the new catalog
+    std::atomic_store(&current, std::move(catalog));
+    version.fetch_add(1, std::memory_order_release);
+}
+
+void CatalogManager::reload() {
+    if (!loader) {
+        throw std::runtime_error("The catalog cannot be reloaded.");
+    }
+
+    // Build the new version outside of any lock held by registers, then publish it
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    publish(loader());
+}
+
+bool CatalogManager::reloadInBackground() {
+    if (!loader) {
+        throw std::runtime_error("The catalog cannot be reloaded.");
+    }
+    if (isReloading.exchange(true)) {
+        return false;
+    }
+
+    // The previous thread has finished its reload, since isReloading was clear, but its caller may
+    // still be storing it
+    std::lock_guard<std::mutex> lock(threadMutex);
+    if (reloadThread.joinable()) {
+        reloadThread.join();
+    }
+    reloadThread = std::thread([this]() {
+        try {
+            reload();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << "Catalog reload failed, keeping the current catalog: " << e.what() << std::endl;
+        }
+        isReloading.store(false);
+    });
+    return true;
+}
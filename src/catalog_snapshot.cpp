@@ -0,0 +1,327 @@
+#include "catalog.h"
+#include "mapped_file.h"
+#include "checkout_stats.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    /**
+     * Identifies a file as a catalog snapshot.
+    */
+    const char snapshotMagic[8] = {'S', 'M', 'K', 'T', 'S', 'N', 'A', 'P'};
+
+    /**
+     * The version of the snapshot format. Must be incremented whenever the layout or hashName changes.
+    */
+    const std::uint32_t snapshotVersion = 3;
+
+    /**
+     * Written in native byte order to detect snapshots written on a machine with a different byte order.
+    */
+    const std::uint32_t byteOrderMark = 0x01020304;
+
+    /**
+     * The fixed size header at the start of a snapshot file. The header is followed by the sections
+     * of the snapshot, in the order of SnapshotLayout. Each section starts at an 8 byte aligned
+     * offset so the sections of a mapped snapshot can be read in place.
+    */
+    struct SnapshotHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t itemCount;
+        std::uint64_t dealCount;
+        std::uint64_t dealItemCount;
+        std::uint64_t namePoolSize;
+        std::uint64_t indexSize;
+        std::uint64_t checksum;
+    };
+
+    /**
+     * The terms of a deal in a snapshot.
+    */
+    struct SnapshotDealTerms {
+        std::int32_t type;
+        std::int32_t buyCount;
+        std::int32_t freeCount;
+        std::int32_t reserved;
+        std::int64_t bundlePrice;
+    };
+
+    /**
+     * The offsets of the sections of a snapshot from the start of the file.
+    */
+    struct SnapshotLayout {
+        /**
+         * Offsets of each item's name in the name pool, as itemCount + 1 uint64 values.
+        */
+        size_t nameOffsets;
+
+        /**
+         * Item prices in cents, as itemCount int64 values.
+        */
+        size_t prices;
+
+        /**
+         * The terms of each deal, as dealCount SnapshotDealTerms values.
+        */
+        size_t dealTerms;
+
+        /**
+         * Offsets of each deal's first item in dealItems, as dealCount + 1 uint64 values.
+        */
+        size_t dealOffsets;
+
+        /**
+         * Item ids of all deals, each deal sorted by price, as dealItemCount int32 values.
+        */
+        size_t dealItems;
+
+        /**
+         * The number of units of each deal item in a group, parallel to dealItems, as dealItemCount int32 values.
+        */
+        size_t dealItemCounts;
+
+        /**
+         * The slots of the item index, as indexSize pairs of a uint32 hash tag and an int32 item id.
+        */
+        size_t index;
+
+        /**
+         * All item names, concatenated.
+        */
+        size_t namePool;
+
+        /**
+         * The total size of the file.
+        */
+        size_t size;
+    };
+
+    /**
+     * Rounds a size up to a multiple of 8.
+    */
+    size_t align8(size_t size) {
+        return (size + 7) & ~static_cast<size_t>(7);
+    }
+
+    /**
+     * Computes the section offsets of a snapshot from the counts in its header.
+    */
+    SnapshotLayout computeLayout(const SnapshotHeader& header) {
+        SnapshotLayout layout;
+        layout.nameOffsets = align8(sizeof(SnapshotHeader));
+        layout.prices = align8(layout.nameOffsets + (header.itemCount + 1) * sizeof(std::uint64_t));
+        layout.dealTerms = align8(layout.prices + header.itemCount * sizeof(std::int64_t));
+        layout.dealOffsets = align8(layout.dealTerms + header.dealCount * sizeof(SnapshotDealTerms));
+        layout.dealItems = align8(layout.dealOffsets + (header.dealCount + 1) * sizeof(std::uint64_t));
+        layout.dealItemCounts = align8(layout.dealItems + header.dealItemCount * sizeof(std::int32_t));
+        layout.index = align8(layout.dealItemCounts + header.dealItemCount * sizeof(std::int32_t));
+        layout.namePool = align8(layout.index + header.indexSize * 2 * sizeof(std::int32_t));
+        layout.size = layout.namePool + header.namePoolSize;
+        return layout;
+    }
+
+    /**
+     * Checksums a buffer 8 bytes at a time.
+    */
+    std::uint64_t checksum(const char* data, size_t size) {
+        const std::uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+        std::uint64_t hash = size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            hash = (((hash << 5) | (hash >> 59)) ^ word) * multiplier;
+        }
+        for (; i < size; ++i) {
+            hash = (((hash << 5) | (hash >> 59)) ^ static_cast<unsigned char>(data[i])) * multiplier;
+        }
+        return hash ^ (hash >> 32);
+    }
+
+    /**
+     * Gets a typed pointer to a section of a snapshot buffer.
+    */
+    template <typename T>
+    T* section(char* base, size_t offset) {
+        return reinterpret_cast<T*>(base + offset);
+    }
+
+    /**
+     * Gets a typed pointer to a section of a read-only snapshot buffer.
+    */
+    template <typename T>
+    const T* section(const char* base, size_t offset) {
+        return reinterpret_cast<const T*>(base + offset);
+    }
+}
+
+void Catalog::saveSnapshot(const std::string& filepath) const {
+    // Fill in header counts
+    SnapshotHeader header;
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+    header.version = snapshotVersion;
+    header.byteOrder = byteOrderMark;
+    header.itemCount = itemPrices.size();
+    header.dealCount = dealTerms.size();
+    header.dealItemCount = dealItemIds.size();
+    header.namePoolSize = nameOffsets.back();
+    header.indexSize = itemIndex.size();
+
+    // Write sections into a zeroed buffer so padding is deterministic
+    SnapshotLayout layout = computeLayout(header);
+    std::vector<char> buffer(layout.size, 0);
+    char* base = buffer.data();
+
+    // The item and deal columns are stored as sections of the same layout, so each is copied as is
+    std::copy(nameOffsets.begin(), nameOffsets.end(), section<std::uint64_t>(base, layout.nameOffsets));
+    std::copy(itemPrices.begin(), itemPrices.end(), section<std::int64_t>(base, layout.prices));
+    std::copy(namePool, namePool + nameOffsets.back(), section<char>(base, layout.namePool));
+
+    SnapshotDealTerms* terms = section<SnapshotDealTerms>(base, layout.dealTerms);
+    for (size_t dealId = 0; dealId < dealTerms.size(); ++dealId) {
+        const DealTerms& deal = dealTerms[dealId];
+        terms[dealId] = {static_cast<std::int32_t>(deal.type), deal.buyCount, deal.freeCount, 0, deal.bundlePrice.getCents()};
+    }
+    std::copy(dealOffsets.begin(), dealOffsets.end(), section<std::uint64_t>(base, layout.dealOffsets));
+    std::copy(dealItemIds.begin(), dealItemIds.end(), section<std::int32_t>(base, layout.dealItems));
+    std::copy(dealItemCounts.begin(), dealItemCounts.end(), section<std::int32_t>(base, layout.dealItemCounts));
+
+    std::copy(itemIndex.begin(), itemIndex.end(), section<IndexSlot>(base, layout.index));
+
+    // Checksum everything after the header, then write the header
+    header.checksum = checksum(base + sizeof(SnapshotHeader), layout.size - sizeof(SnapshotHeader));
+    std::memcpy(base, &header, sizeof(SnapshotHeader));
+
+    // Write to a temporary file and rename it, so readers never see a partially written snapshot
+    std::string tempFilepath = filepath + ".tmp";
+    {
+        std::ofstream file(tempFilepath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open file: '" + tempFilepath + "' for writing.");
+        }
+        file.write(buffer.data(), buffer.size());
+        if (!file) {
+            throw std::runtime_error("Cannot write file: '" + tempFilepath + "'.");
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempFilepath, filepath, error);
+    if (error) {
+        throw std::runtime_error("Cannot write file: '" + filepath + "'.");
+    }
+}
+
+void Catalog::loadSnapshot(const std::string& filepath) {
+    CHECKOUT_STATS_PHASE(LoadSnapshot);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Open file, which stays mapped for the lifetime of the catalog
+    auto file = std::make_unique<MappedFile>(filepath);
+    if (!file->isOpen()) {
+        throw std::runtime_error("Cannot open file: '" + filepath + "'. Please ensure it exists.");
+    }
+    std::string_view contents = file->contents();
+    const char* base = contents.data();
+
+    // Check header
+    SnapshotHeader header;
+    if (contents.size() < sizeof(SnapshotHeader)) {
+        throw std::runtime_error("File: '" + filepath + "' is not a catalog snapshot.");
+    }
+    std::memcpy(&header, base, sizeof(SnapshotHeader));
+    if (std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0) {
+        throw std::runtime_error("File: '" + filepath + "' is not a catalog snapshot.");
+    }
+    if (header.version != snapshotVersion || header.byteOrder != byteOrderMark) {
+        throw std::runtime_error("Catalog snapshot: '" + filepath + "' was written by an incompatible version. Please rebuild it.");
+    }
+
+    // Check size and checksum before reading any sections
+    if (header.itemCount > contents.size() || header.dealCount > contents.size()
+        || header.dealItemCount > contents.size() || header.indexSize > contents.size()
+        || header.namePoolSize > contents.size()) {
+        throw std::runtime_error("Catalog snapshot: '" + filepath + "' is corrupt. Please rebuild it.");
+    }
+    SnapshotLayout layout = computeLayout(header);
+    if (layout.size != contents.size()
+        || checksum(base + sizeof(SnapshotHeader), layout.size - sizeof(SnapshotHeader)) != header.checksum) {
+        throw std::runtime_error("Catalog snapshot: '" + filepath + "' is corrupt. Please rebuild it.");
+    }
+
+    const std::uint64_t* snapshotNameOffsets = section<std::uint64_t>(base, layout.nameOffsets);
+    const std::int64_t* prices = section<std::int64_t>(base, layout.prices);
+    const SnapshotDealTerms* terms = section<SnapshotDealTerms>(base, layout.dealTerms);
+    const std::uint64_t* snapshotDealOffsets = section<std::uint64_t>(base, layout.dealOffsets);
+    const std::int32_t* dealItems = section<std::int32_t>(base, layout.dealItems);
+    const std::int32_t* dealItemUnits = section<std::int32_t>(base, layout.dealItemCounts);
+    const IndexSlot* index = section<IndexSlot>(base, layout.index);
+    const char* snapshotNamePool = section<char>(base, layout.namePool);
+
+    // Check every name lies within the name pool, which is read in place from the mapped file
+    for (size_t id = 0; id < header.itemCount; ++id) {
+        if (snapshotNameOffsets[id] > snapshotNameOffsets[id + 1] || snapshotNameOffsets[id + 1] > header.namePoolSize) {
+            throw std::runtime_error("Catalog snapshot: '" + filepath + "' is corrupt. Please rebuild it.");
+        }
+    }
+
+    // Check the deals, which are already sorted by price, have valid items and group sizes
+    std::vector<DealTerms> newTerms(header.dealCount);
+    for (size_t dealId = 0; dealId < header.dealCount; ++dealId) {
+        std::uint64_t first = snapshotDealOffsets[dealId];
+        std::uint64_t last = snapshotDealOffsets[dealId + 1];
+        if (first > last || last > header.dealItemCount) {
+            throw std::runtime_error("Catalog snapshot: '" + filepath + "' is corrupt. Please rebuild it.");
+        }
+        DealTerms& deal = newTerms[dealId];
+        deal.type = static_cast<DealType>(terms[dealId].type);
+        deal.buyCount = terms[dealId].buyCount;
+        deal.freeCount = terms[dealId].freeCount;
+        deal.bundlePrice = Money(terms[dealId].bundlePrice);
+        bool isBuyGetFree = terms[dealId].type == static_cast<std::int32_t>(DealType::BuyGetFree);
+        bool isValid = isBuyGetFree
+            ? deal.buyCount >= 1 && deal.freeCount >= 1 && deal.buyCount + deal.freeCount <= Deal::maxGroupSize
+            : terms[dealId].type == static_cast<std::int32_t>(DealType::Bundle) && last - first <= Deal::maxGroupSize;
+        int groupSize = 0;
+        for (std::uint64_t i = first; i < last && isValid; ++i) {
+            int units = dealItemUnits[i];
+            groupSize += units;
+            isValid = dealItems[i] >= 0 && dealItems[i] < static_cast<std::int64_t>(header.itemCount)
+                && units >= 1 && units <= (isBuyGetFree ? 1 : Deal::maxGroupSize);
+        }
+        if (!isValid || (!isBuyGetFree && groupSize > Deal::maxGroupSize)) {
+            throw std::runtime_error("Catalog snapshot: '" + filepath + "' is corrupt. Please rebuild it.");
+        }
+    }
+
+    // Copy the prebuilt index, which must be a power of 2 and able to hold all items
+    if (header.indexSize < 16 || (header.indexSize & (header.indexSize - 1)) != 0 || header.indexSize < header.itemCount * 2) {
+        throw std::runtime_error("Catalog snapshot: '" + filepath + "' is corrupt. Please rebuild it.");
+    }
+    std::vector<IndexSlot> newIndex(index, index + header.indexSize);
+    for (const IndexSlot& slot : newIndex) {
+        if (slot.itemId < -1 || slot.itemId >= static_cast<std::int64_t>(header.itemCount)) {
+            throw std::runtime_error("Catalog snapshot: '" + filepath + "' is corrupt. Please rebuild it.");
+        }
+    }
+
+    // Replace catalog contents, copying each column from its section at once
+    nameOffsets.assign(snapshotNameOffsets, snapshotNameOffsets + header.itemCount + 1);
+    itemPrices.assign(prices, prices + header.itemCount);
+    itemDealClusterIds.assign(header.itemCount, -1);
+    dealTerms.swap(newTerms);
+    dealOffsets.assign(snapshotDealOffsets, snapshotDealOffsets + header.dealCount + 1);
+    dealItemIds.assign(dealItems, dealItems + header.dealItemCount);
+    dealItemCounts.assign(dealItemUnits, dealItemUnits + header.dealItemCount);
+    itemIndex.swap(newIndex);
+    std::vector<char>().swap(nameStorage);
+    namePool = snapshotNamePool;
+    snapshotFile = std::move(file);
+    buildDealClusters();
+
+    recordLoad(filepath, contents.size(), start);
+}
@@ -1,280 +1,575 @@
 
 #include "checkout_register.h"
 #include "io_helper.h"
+#include "checkout_stats.h"
+#include "text_receipt_sink.h"
+#include "pricing_kernel.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
-#include <iomanip>
 #include <ctime>
-#include <sstream>
 
-CheckoutRegister::CheckoutRegister(const Catalog& catalog) : catalog(catalog) {}
+CheckoutRegister::CheckoutRegister(const Catalog& catalog) : catalogManager(nullptr),
+    catalog(std::shared_ptr<const Catalog>(&catalog, [](const Catalog*) {})), catalogVersion(0), isSessionOpen(false),
+    session(1), removedLines(0), journal(nullptr), journalId(0) {
+    resetCatalogState();
+}
+
+CheckoutRegister::CheckoutRegister(const CatalogManager& catalogManager) : catalogManager(&catalogManager),
+    catalogVersion(0), isSessionOpen(false), session(1), removedLines(0), journal(nullptr), journalId(0) {
+    // Read the version before the catalog, like refreshCatalog, so a version published in between is
+    // picked up by the first session instead of being recorded against the older catalog
+    catalogVersion = catalogManager.getVersion();
+    catalog = catalogManager.acquire();
+    resetCatalogState();
+}
+
+void CheckoutRegister::resetCatalogState() {
+    // Mark every item as last written before the first session
+    cartLineOfItem.assign(catalog->getItemCount(), {0, -1});
+    savingsOfCluster.assign(catalog->getDealClusterCount(), Money());
+    potentialClusters.resize(catalog->getDealClusterCount());
+    batchClusters.resize(catalog->getDealClusterCount());
+    session = 1;
+}
+
+int CheckoutRegister::lineOfItem(int itemId) const {
+    const ItemLine& itemLine = cartLineOfItem[itemId];
+    return itemLine.session == session ? itemLine.line : -1;
+}
+
+void CheckoutRegister::refreshCatalog() {
+    // Only touch the shared catalog pointer when a new version has been published
+    std::uint64_t version = catalogManager == nullptr ? catalogVersion : catalogManager->getVersion();
+    if (version == catalogVersion) {
+        return;
+    }
+    catalogVersion = version;
+    catalog = catalogManager->acquire();
+
+    // Resize the per item and per deal cluster state for the new version, which is empty between sessions
+    resetCatalogState();
+}
+
+const Catalog& CheckoutRegister::getCatalog() const {
+    return *catalog;
+}
+
+void CheckoutRegister::scanItem(std::string_view itemName, int quantity) {
+    ScanStatus status = tryScanItem(itemName, quantity);
+    if (status != ScanStatus::Ok) {
+        throw std::runtime_error(scanErrorMessage({itemName, -1, quantity}, status));
+    }
+}
+
+ScanStatus CheckoutRegister::tryScanItem(std::string_view itemName, int quantity) {
+    CHECKOUT_STATS_PHASE(ScanItem);
 
-void CheckoutRegister::scanItem(const std::string& itemName, int quantity) {
     // Check quantity is valid
     if (quantity < 1) {
-        throw std::runtime_error("Item quantity for item '" + itemName + "' must be an integer larger than 0.");
+        return ScanStatus::InvalidQuantity;
+    }
+
+    // Look the item up in the newest catalog while the cart is still empty
+    if (!isSessionOpen) {
+        refreshCatalog();
     }
 
     // Get item id and ensure item exists
-    int itemId = catalog.getItemId(itemName);
+    int itemId = catalog->getItemId(itemName);
     if (itemId == -1) {
-        throw std::runtime_error("Item '" + itemName + "' does not exist in Supermarket.");
+        return ScanStatus::UnknownItem;
+    }
+
+    // The first valid scan starts the session, pinning the catalog version until it ends
+    isSessionOpen = true;
+
+    // Add quantity to the item's cart line, and update the running totals
+    addToCart(itemId, quantity);
+    updateRunningTotals(itemId, quantity);
+    return ScanStatus::Ok;
+}
+
+size_t CheckoutRegister::scanBatch(const ScanEntry* entries, size_t count, ScanStatus* statuses) {
+    CHECKOUT_STATS_PHASE(ScanBatch);
+
+    // Look the items up in the newest catalog while the cart is still empty
+    if (!isSessionOpen) {
+        refreshCatalog();
+    }
+
+    // Look up the names of the entries without item ids together
+    batchNames.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (entries[i].itemId == -1) {
+            batchNames.push_back(entries[i].itemName);
+        }
+    }
+    batchItemIds.resize(batchNames.size());
+    catalog->getItemIds(batchNames.data(), batchNames.size(), batchItemIds.data());
+
+    // Add each valid entry to the cart and the running price, noting the deal clusters of its item
+    batchClusters.clear();
+    size_t failed = 0;
+    size_t nameIndex = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const ScanEntry& entry = entries[i];
+        int itemId = entry.itemId == -1 ? batchItemIds[nameIndex++] : entry.itemId;
+        if (entry.quantity < 1) {
+            statuses[i] = ScanStatus::InvalidQuantity;
+        } else if (itemId < 0 || itemId >= catalog->getItemCount()) {
+            statuses[i] = ScanStatus::UnknownItem;
+        } else {
+            statuses[i] = ScanStatus::Ok;
+        }
+        if (statuses[i] != ScanStatus::Ok) {
+            failed++;
+            continue;
+        }
+
+        addToCart(itemId, entry.quantity);
+        cartPrice += Money(catalog->getItemPrices()[itemId]) * entry.quantity;
+        int clusterId = catalog->getItemDealClusterId(itemId);
+        if (clusterId != -1) {
+            batchClusters.insert(clusterId);
+        }
+    }
+
+    // Any valid entry starts the session, pinning the catalog version until it ends
+    if (failed < count) {
+        isSessionOpen = true;
+    }
+
+    // Recalculate the savings of each changed deal cluster once
+    batchClusters.forEach([this](int clusterId) {
+        Money savings = solveCluster(clusterId, nullptr);
+        cartSavings += savings - savingsOfCluster[clusterId];
+        savingsOfCluster[clusterId] = savings;
+    });
+    return failed;
+}
+
+std::string CheckoutRegister::scanErrorMessage(const ScanEntry& entry, ScanStatus status) {
+    // Name the item the way it was scanned, by name or by id
+    std::string item = entry.itemId == -1 ? "'" + std::string(entry.itemName) + "'"
+                                          : "with id '" + std::to_string(entry.itemId) + "'";
+    if (status == ScanStatus::InvalidQuantity) {
+        return "Item quantity for item " + item + " must be an integer larger than 0.";
+    }
+    if (status == ScanStatus::NotInCart) {
+        return "Item " + item + " is not currently in your cart.";
+    }
+    return "Item " + item + " does not exist in Supermarket.";
+}
+
+void CheckoutRegister::addToCart(int itemId, int quantity) {
+    // Journal the scan under the item's catalog name
+    if (journal != nullptr) {
+        journal->append(JournalEventType::Scan, journalId, catalog->getItem(itemId).name, quantity);
     }
 
     // Check if item has already been added to cart, if so update quantity and return
-    auto it = quantityOfCartItem.find(itemId);
-    if (it != quantityOfCartItem.end()) {
-        it->second += quantity; 
+    int line = lineOfItem(itemId);
+    if (line != -1) {
+        cartQuantities[line] += quantity;
         return;
     }
 
-    // New item is being added, add id to cart and quantity map
+    // New item is being added, add a line for it to the cart
+    cartLineOfItem[itemId] = {session, static_cast<std::int32_t>(cartIds.size())};
     cartIds.push_back(itemId);
-    quantityOfCartItem[itemId] = quantity;
+    cartQuantities.push_back(quantity);
+    cartUnitPrices.push_back(catalog->getItemPrices()[itemId]);
+
+    // Check if item may be eligible for deals, and add its deal cluster to potential clusters
+    // the first time one of its items is scanned
+    int clusterId = catalog->getItemDealClusterId(itemId);
+    if (clusterId != -1 && potentialClusters.insert(clusterId)) {
+        savingsOfCluster[clusterId] = Money();
+    }
+}
 
-    // Check if item may be eligible for deal, and add deal to potential deals
-    const CatalogItem& item = catalog.getItem(itemId);
-    if (item.dealId != -1) {
-        potentialDeals.insert(item.dealId);
+void CheckoutRegister::removeItem(std::string_view itemName) {
+    ScanStatus status = tryRemoveItem(itemName);
+    if (status != ScanStatus::Ok) {
+        throw std::runtime_error(scanErrorMessage({itemName, -1, 0}, status));
     }
 }
 
-void CheckoutRegister::removeItem(const std::string& itemName) {
+ScanStatus CheckoutRegister::tryRemoveItem(std::string_view itemName) {
+    CHECKOUT_STATS_PHASE(RemoveItem);
+
     // Get item id and ensure item exists
-    int itemId = catalog.getItemId(itemName);
+    int itemId = catalog->getItemId(itemName);
     if (itemId == -1) {
-        throw std::runtime_error("Item '" + itemName + "' does not exist in Supermarket.");
+        return ScanStatus::UnknownItem;
     }
 
     // Check that item is in cart
-    auto it = quantityOfCartItem.find(itemId);
-    if (it == quantityOfCartItem.end()) {
-        throw std::runtime_error("Item '" + itemName + "' is not currently in your cart.");
+    int line = lineOfItem(itemId);
+    if (line == -1) {
+        return ScanStatus::NotInCart;
+    }
+
+    if (journal != nullptr) {
+        journal->append(JournalEventType::Remove, journalId, catalog->getItem(itemId).name);
+    }
+
+    // Empty the item's line, and compact the cart once most of its lines are empty
+    int quantity = cartQuantities[line];
+    cartQuantities[line] = 0;
+    cartLineOfItem[itemId].line = -1;
+    removedLines++;
+    updateRunningTotals(itemId, -quantity);
+    if (removedLines * 2 > static_cast<int>(cartIds.size())) {
+        compactCart();
+    }
+    return ScanStatus::Ok;
+}
+
+void CheckoutRegister::compactCart() {
+    // Shift remaining lines forward over removed lines
+    size_t next = 0;
+    for (size_t line = 0; line < cartIds.size(); ++line) {
+        if (cartQuantities[line] == 0) {
+            continue;
+        }
+        cartIds[next] = cartIds[line];
+        cartQuantities[next] = cartQuantities[line];
+        cartUnitPrices[next] = cartUnitPrices[line];
+        cartLineOfItem[cartIds[next]].line = next;
+        next++;
+    }
+    cartIds.resize(next);
+    cartQuantities.resize(next);
+    cartUnitPrices.resize(next);
+    removedLines = 0;
+}
+
+Money CheckoutRegister::solveCluster(int clusterId, DealPlan* plan) {
+    DealCluster cluster = catalog->getDealCluster(clusterId);
+
+    // Gather the cart quantities of the cluster's items
+    clusterQuantities.resize(cluster.itemIds.size());
+    for (size_t slot = 0; slot < cluster.itemIds.size(); ++slot) {
+        int line = lineOfItem(cluster.itemIds[slot]);
+        clusterQuantities[slot] = line == -1 ? 0 : cartQuantities[line];
+    }
+    return dealSolver.solve(*catalog, clusterId, clusterQuantities.data(), plan).savings;
+}
+
+void CheckoutRegister::updateRunningTotals(int itemId, int quantityChange) {
+    cartPrice += Money(catalog->getItemPrices()[itemId]) * quantityChange;
+
+    // Only the savings of the item's own deal cluster can change
+    int clusterId = catalog->getItemDealClusterId(itemId);
+    if (clusterId != -1) {
+        Money savings = solveCluster(clusterId, nullptr);
+        cartSavings += savings - savingsOfCluster[clusterId];
+        savingsOfCluster[clusterId] = savings;
     }
+}
+
+Money CheckoutRegister::currentTotal() const {
+    return cartPrice - cartSavings;
+}
 
-    // Remove item from cartIds, and cartQuantities
-    cartIds.remove(itemId);
-    quantityOfCartItem.erase(itemId);
+Money CheckoutRegister::currentSavings() const {
+    return cartSavings;
 }
 
-void::CheckoutRegister::printCart() {
+void::CheckoutRegister::printCart(std::ostream& out) {
     // Column widths
     const int nameWidth = 26;   
     const int quantityWidth = 8;
     const int totalWidth = nameWidth + quantityWidth;
     
     // Header
-    IOHelper::printSolidLine(totalWidth);
-    IOHelper::printCentered("Your Cart", totalWidth);
-    IOHelper::printSolidLine(totalWidth);
+    receiptWriter.clear();
+    receiptWriter.solidLine(totalWidth);
+    receiptWriter.centeredLine("Your Cart", totalWidth);
+    receiptWriter.solidLine(totalWidth);
 
     // Items header
-    std::cout << std::setw(nameWidth) << std::left << "Item";
-    std::cout << std::setw(quantityWidth) << std::right << "Quantity" << std::endl;
-    IOHelper::printDashedLine(totalWidth);
-
-    // Iterate over items in cart
-    for (const int& itemId : cartIds) {
+    receiptWriter.appendLeft("Item", nameWidth);
+    receiptWriter.appendRight("Quantity", quantityWidth);
+    receiptWriter.endLine();
+    receiptWriter.dashedLine(totalWidth);
+
+    // Iterate over items in cart, skipping removed lines
+    for (size_t line = 0; line < cartIds.size(); ++line) {
+        if (cartQuantities[line] == 0) {
+            continue;
+        }
         // Print name
-        std::cout << std::setw(nameWidth) << std::left << catalog.getItem(itemId).name;
+        receiptWriter.appendLeft(catalog->getItem(cartIds[line]).name, nameWidth);
         //Print quantity
-        std::cout << std::setw(quantityWidth) << std::right << quantityOfCartItem[itemId] << std::endl;
+        receiptWriter.appendRight(static_cast<long long>(cartQuantities[line]), quantityWidth);
+        receiptWriter.endLine();
     }
-    IOHelper::printSolidLine(totalWidth);
+    receiptWriter.solidLine(totalWidth);
+
+    // Running total
+    receiptWriter.append("Total: ");
+    receiptWriter.append(currentTotal());
+    receiptWriter.append(" (You save ");
+    receiptWriter.append(currentSavings());
+    receiptWriter.append(")");
+    receiptWriter.endLine();
+    receiptWriter.solidLine(totalWidth);
+    receiptWriter.writeTo(out);
+    out.flush();
 }
 
 void CheckoutRegister::calculateDeals() {
-    // Iterate over potential deals
-    for (const int& dealId : potentialDeals) {
-
-        // Get deal from catalog
-        const auto& deal = catalog.getDeal(dealId);
-
-        // Array to store current deal group
-        std::array<int, 3> curGroup = {-1, -1, -1};
-
-        // Track current index in current group
-        int curIndex = 0;
-
-        // Iterate over ids in deal
-        for (const int& itemId : deal) {
-            // Check that item is included in cart and if so get quantity, if not continue to next item
-            auto it = quantityOfCartItem.find(itemId);
-            if (it == quantityOfCartItem.end()) {
-                continue;
-            }
-            int quantity = it->second;
-
-            while (quantity > 0) {
-                // Fill current group with item
-                while (curIndex < 3 && quantity > 0) {
-                    curGroup[curIndex++] = itemId; 
-                    quantity--;
-                }
-
-                // If the current group is full, add it to the deal groups and reset
-                if (curIndex == 3) {
-                    dealGroups.push_back(curGroup);
-                    // Reset group and index
-                    curGroup.fill(-1);
-                    curIndex = 0;
-                }
+    CHECKOUT_STATS_PHASE(CalculateDeals);
+
+    dealsPrice = Money();
+    dealsSavings = Money();
+
+    // Find the best groups of each potential deal cluster, in cluster id order so deal groups are
+    // listed on receipts in the same order however the cart was scanned
+    potentialClusters.forEach([this](int clusterId) {
+        size_t firstSegment = dealPlan.segments.size();
+        Money savings = solveCluster(clusterId, &dealPlan);
+
+        // Remove the grouped units from the cart lines
+        Money groupedPrice;
+        for (size_t i = firstSegment; i < dealPlan.segments.size(); ++i) {
+            const DealPlan::Segment& segment = dealPlan.segments[i];
+            for (int run = segment.firstRun; run < segment.firstRun + segment.runCount; ++run) {
+                const DealPlan::Run& dealRun = dealPlan.runs[run];
+                int units = dealRun.quantity * segment.repeat;
+                cartQuantities[lineOfItem(dealRun.itemId)] -= units;
+                groupedPrice += Money(catalog->getItemPrices()[dealRun.itemId]) * units;
             }
         }
-
-        // Set quantities of all items in deal to 0
-        for (const int& itemId : deal) {
-            auto it = quantityOfCartItem.find(itemId);
-            if (it != quantityOfCartItem.end()) {
-                it->second = 0;
-            }
-        }
-
-        // Update quantity for remaining 1-2 items that were not included in a deal
-        while (curIndex > 0) {
-            int last_item = curGroup[--curIndex];
-            quantityOfCartItem[last_item]++;
-        }
-    }
+        dealsPrice += groupedPrice - savings;
+        dealsSavings += savings;
+    });
 }
 
 
-void CheckoutRegister::printReceipt(std::ostream& out) {
-    double total = 0;
-
-    // Column widths
-    const int itemWidth = 30;   
-    const int priceWidth = 10;
-    const int totalWidth = itemWidth + priceWidth;
-    
-    // Receipt header section
-    IOHelper::printSolidLine(totalWidth, out);
-    IOHelper::printCentered("Supermarket", totalWidth, out);
-    IOHelper::printCentered("Customer Receipt", totalWidth, out);
-    
-    // Get current time
-    auto now = std::chrono::system_clock::now();
-    std::time_t now_time = std::chrono::system_clock::to_time_t(now);
-
-    // Format date and time
-    std::tm* localTime = std::localtime(&now_time);
-    std::ostringstream dateTimeStream;
-    dateTimeStream << std::put_time(localTime, "%Y-%m-%d %H:%M");
-
-    // Print date and time
-    IOHelper::printCentered(dateTimeStream.str(), totalWidth, out);
-    IOHelper::printSolidLine(totalWidth, out);
-
-    if (dealGroups.size() > 0) {
-        // Deals section
-        // Track total savings
-        double savings = 0;
-
-        // Deal header
-        IOHelper::printCentered("Deals", totalWidth, out);
-        IOHelper::printSolidLine(totalWidth, out);
-        out << std::setw(itemWidth) << std::left << "Item";
-        out << std::setw(priceWidth) << std::right << "Price" << std::endl;
-        IOHelper::printDashedLine(totalWidth, out);
-        
-        // Iterate over all deals groups
-        for (const std::array<int,3>& group : dealGroups) {
-            // Iterate over each item in group
-            for (int i = 0; i < 3; i++) {
-                // Get item data
-                const CatalogItem& item = catalog.getItem(group[i]);
-                double price = item.price;
-                std::string quantity = " (1)";
-
-                // Check if first and second items are the same
-                if (i == 0 && group[0] == group[1]) {
-                    // Double price and quantity
-                    price *= 2;
-                    quantity = " (2)";
-                    // Skip second item
-                    i++;
-                }
-
-                // Print name
-                out << std::setw(itemWidth) << std::left << item.name + quantity;
-                
-                // Print price, checking if free
-                if (i == 2) {
-                    // Last item in group is free
-                    out << std::setw(priceWidth) << std::right << "FREE" << std::endl;
-                    savings += price;
-                } else {
-                    std::ostringstream priceStream;
-                    priceStream << "$" << std::fixed << std::setprecision(2) << price;
-                    out << std::setw(priceWidth) << std::right << priceStream.str() << std::endl;
-                    total += price;
+void CheckoutRegister::buildReceipt(int cartId) {
+    receipt.cartId = cartId;
+    receipt.time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    receipt.dealLines.clear();
+    receipt.dealGroups.clear();
+    receipt.items.clear();
+
+    // Expand the deal plan into groups of items
+    std::array<int, Deal::maxGroupSize> group;
+    for (const DealPlan::Segment& segment : dealPlan.segments) {
+        Deal deal = catalog->getDeal(segment.dealId);
+        int groupSize = deal.groupSize();
+        bool isBundle = deal.type == DealType::Bundle;
+        int unitCount = 0;
+
+        for (int repeat = 0; repeat < segment.repeat; ++repeat) {
+            for (int run = segment.firstRun; run < segment.firstRun + segment.runCount; ++run) {
+                const DealPlan::Run& dealRun = dealPlan.runs[run];
+                for (int unit = 0; unit < dealRun.quantity; ++unit) {
+                    // Add unit to current group, and add lines for the group once it is full
+                    group[unitCount++] = dealRun.itemId;
+                    if (unitCount < groupSize) {
+                        continue;
+                    }
+                    unitCount = 0;
+
+                    int groupIndex = receipt.dealGroups.size();
+                    ReceiptDealGroup dealGroup = {Money(), Money(), isBundle};
+                    for (int i = 0; i < groupSize; ) {
+                        // Get item data, the last freeCount units of a group with free items being free
+                        CatalogItem item = catalog->getItem(group[i]);
+                        bool isFree = !isBundle && i >= deal.buyCount;
+
+                        // Combine the following units if they are the same item and also free or paid
+                        int quantity = 1;
+                        while (i + quantity < groupSize && group[i + quantity] == group[i]
+                            && (isBundle || (i + quantity >= deal.buyCount) == isFree)) {
+                            quantity++;
+                        }
+                        i += quantity;
+
+                        Money price = item.price * quantity;
+                        if (isFree) {
+                            dealGroup.savings += price;
+                            price = Money();
+                        }
+                        dealGroup.price += price;
+                        receipt.dealLines.push_back({item.name, quantity, price, groupIndex, isFree});
+                    }
+
+                    // A bundle's savings are the difference from the regular prices of its items
+                    if (isBundle) {
+                        dealGroup.savings = dealGroup.price - deal.bundlePrice;
+                        dealGroup.price = deal.bundlePrice;
+                    }
+                    receipt.dealGroups.push_back(dealGroup);
                 }
             }
-            IOHelper::printDashedLine(totalWidth, out);
         }
-        
-        // Print savings
-        out << "You saved " << "$" << std::fixed << std::setprecision(2) << savings << "!" << std::endl;
-        IOHelper::printSolidLine(totalWidth, out);
-
-        // Print items header
-        IOHelper::printCentered("Remaining Items", totalWidth, out);
-        IOHelper::printSolidLine(totalWidth, out);
-    } else {
-        // Print items header
-        IOHelper::printCentered("Items", totalWidth, out);
-        IOHelper::printSolidLine(totalWidth, out);
     }
+    receipt.savings = dealsSavings;
 
-    // Items section
-    out << std::setw(itemWidth) << std::left << "Item";
-    out << std::setw(priceWidth) << std::right << "Price" << std::endl;
-    IOHelper::printDashedLine(totalWidth, out);
+    // Price the remaining quantity of every cart line at once, adding it to the deal groups which
+    // are already priced
+    linePrices.resize(cartIds.size());
+    receipt.total = dealsPrice + Money(PricingKernel::priceLines(cartUnitPrices.data(), cartQuantities.data(),
+                                                                 cartIds.size(), linePrices.data()));
 
     // Iterate over items in cart
-    for (const int& itemId : cartIds) {    
-        // Get item quantity, skip if item has quantity 0 (due to being fully included in deals)
-        auto it = quantityOfCartItem.find(itemId);
-        if (it == quantityOfCartItem.end() || it->second == 0) {
+    for (size_t line = 0; line < cartIds.size(); ++line) {
+        // Get item quantity, skip if item has quantity 0 (due to being removed or fully included in deals)
+        int quantity = cartQuantities[line];
+        if (quantity == 0) {
             continue;
         }
 
-        // Get quantity and item data
-        int quantity = it->second;
-        const auto& item = catalog.getItem(itemId);
+        // Get item data
+        CatalogItem item = catalog->getItem(cartIds[line]);
+        receipt.items.push_back({item.name, quantity, Money(linePrices[line]), -1, false});
+    }
+}
 
-        // Print name
-        out << std::setw(itemWidth) << std::left << item.name + " (" + std::to_string(quantity) + ") ";
-
-        // Print price
-        double price = quantity * item.price;
-        std::ostringstream priceStream;
-        priceStream << "$" << std::fixed << std::setprecision(2) << price;
-        out << std::setw(priceWidth) << std::right << priceStream.str() << std::endl;
-        total += price;
-    }
-    IOHelper::printSolidLine(totalWidth, out);
-
-    // Total section
-    out << std::setw(itemWidth) << std::left << "Grand Total:";
-    std::ostringstream totalStream;
-    totalStream << "$" << std::fixed << std::setprecision(2) << total;
-    out << std::setw(priceWidth) << std::right << totalStream.str() << std::endl;
-
-    IOHelper::printSolidLine(totalWidth, out);
-    IOHelper::printCentered("Thank you for shopping with us!", totalWidth, out);
-    IOHelper::printSolidLine(totalWidth, out);
+void CheckoutRegister::printReceipt(std::ostream& out) {
+    CHECKOUT_STATS_PHASE(PrintReceipt);
+
+    // Format the whole receipt, then emit it with a single write
+    buildReceipt(-1);
+    receiptWriter.clear();
+    TextReceiptSink::format(receipt, receiptWriter);
+    receiptWriter.writeTo(out);
+    out.flush();
 }
 
 void CheckoutRegister::clearSession() {
+    if (journal != nullptr && isSessionOpen) {
+        journal->append(JournalEventType::Cancel, journalId);
+    }
+    endSession();
+}
+
+void CheckoutRegister::endSession() {
+    CHECKOUT_STATS_PHASE(ClearSession);
+
+    // Start a new session, which leaves the line of every item out of date without visiting it.
+    // Once every 2^32 sessions the counter wraps around, and only then are the stale sessions of
+    // all items reset.
+    session++;
+    if (session == 0) {
+        std::fill(cartLineOfItem.begin(), cartLineOfItem.end(), ItemLine{0, -1});
+        session = 1;
+    }
+
+    // Empty the cart, keeping the capacity of all containers
     cartIds.clear();
-    quantityOfCartItem.clear();
-    potentialDeals.clear();
-    dealGroups.clear();
+    cartQuantities.clear();
+    cartUnitPrices.clear();
+    removedLines = 0;
+
+    // Reset running totals
+    cartPrice = Money();
+    cartSavings = Money();
+    potentialClusters.clear();
+    dealPlan.clear();
+    isSessionOpen = false;
+
+    // Release the catalog version as soon as the cart is empty, so an idle register does not hold
+    // on to a catalog a reload has replaced
+    refreshCatalog();
 }
 
 void CheckoutRegister::checkOut(std::ostream& receiptOutStream) {
     calculateDeals();
+    commitCheckOut();
     printReceipt(receiptOutStream);
-    clearSession();
+    endSession();
+    CHECKOUT_STATS_END_CART();
+}
+
+void CheckoutRegister::checkOut(ReceiptSink& sink, int cartId) {
+    calculateDeals();
+    commitCheckOut();
+    {
+        CHECKOUT_STATS_PHASE(PrintReceipt);
+        buildReceipt(cartId);
+        sink.write(receipt);
+    }
+    endSession();
+    CHECKOUT_STATS_END_CART();
+}
+
+void CheckoutRegister::commitCheckOut() {
+    // Make the checkout durable before the receipt is printed, so a recovered journal never
+    // reopens a cart the customer has a receipt for
+    if (journal != nullptr && isSessionOpen) {
+        journal->waitUntilDurable(journal->append(JournalEventType::Checkout, journalId));
+    }
+}
+
+void CheckoutRegister::setJournal(Journal* journal, std::uint32_t registerId) {
+    this->journal = journal;
+    journalId = registerId;
+    if (journal == nullptr) {
+        return;
+    }
+
+    // Write the lines of the open cart, skipping removed items
+    for (size_t line = 0; line < cartIds.size(); ++line) {
+        if (cartQuantities[line] > 0) {
+            journal->append(JournalEventType::Scan, journalId, catalog->getItem(cartIds[line]).name, cartQuantities[line]);
+        }
+    }
+}
+
+void CheckoutRegister::applyJournalEvent(const JournalEvent& event) {
+    switch (event.type) {
+        case JournalEventType::Scan:
+            tryScanItem(event.itemName, event.quantity);
+            break;
+        case JournalEventType::Remove:
+            tryRemoveItem(event.itemName);
+            break;
+        case JournalEventType::Checkout:
+        case JournalEventType::Cancel:
+            endSession();
+            break;
+    }
+}
+
+std::unique_ptr<Journal> CheckoutRegister::recoverJournal(const std::string& filepath, const std::vector<CheckoutRegister*>& registers) {
+    // Replay the events of every register into its cart, noting which registers without a register
+    // to replay into still have an open cart
+    std::vector<bool> isMissingCartOpen;
+    Journal::replay(filepath, [&registers, &isMissingCartOpen](const JournalEvent& event) {
+        if (event.registerId < registers.size()) {
+            registers[event.registerId]->applyJournalEvent(event);
+            return;
+        }
+        size_t missingId = event.registerId - registers.size();
+        if (missingId >= isMissingCartOpen.size()) {
+            isMissingCartOpen.resize(missingId + 1, false);
+        }
+        isMissingCartOpen[missingId] = event.type == JournalEventType::Scan || event.type == JournalEventType::Remove;
+    });
+
+    // Refuse to replace a journal whose open carts would be dropped
+    for (size_t missingId = isMissingCartOpen.size(); missingId-- > 0; ) {
+        if (isMissingCartOpen[missingId]) {
+            size_t registerId = registers.size() + missingId;
+            throw std::runtime_error("Journal file '" + filepath + "' has an open cart on register " + std::to_string(registerId)
+                + ", but only " + std::to_string(registers.size()) + " registers are running. Start at least "
+                + std::to_string(registerId + 1) + " lanes to recover it.");
+        }
+    }
+
+    // Start a new journal with the open carts, and only then replace the old journal with it
+    std::unique_ptr<Journal> journal(new Journal(filepath));
+    for (size_t id = 0; id < registers.size(); ++id) {
+        registers[id]->setJournal(journal.get(), id);
+    }
+    journal->publish();
+    return journal;
 }
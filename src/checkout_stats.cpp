@@ -0,0 +1,231 @@
+#include "checkout_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <iomanip>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    /**
+     * A histogram written by a single thread and read by any thread. Writes use relaxed loads and
+     * stores rather than read-modify-write instructions, which is safe with a single writer.
+    */
+    struct ThreadHistogram {
+        std::array<std::atomic<std::uint64_t>, 65> buckets{};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> total{0};
+        std::atomic<std::uint64_t> max{0};
+
+        /**
+         * Adds to a counter owned by the calling thread.
+        */
+        static void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        void record(std::uint64_t value) {
+            int bucket = 0;
+            while (bucket < 64 && (value >> bucket) != 0) {
+                bucket++;
+            }
+            add(buckets[bucket], 1);
+            add(count, 1);
+            add(total, value);
+            if (value > max.load(std::memory_order_relaxed)) {
+                max.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        void mergeInto(CheckoutStats::Histogram& histogram) const {
+            for (size_t b = 0; b < buckets.size(); b++) {
+                histogram.buckets[b] += buckets[b].load(std::memory_order_relaxed);
+            }
+            histogram.count += count.load(std::memory_order_relaxed);
+            histogram.total += total.load(std::memory_order_relaxed);
+            histogram.max = std::max(histogram.max, max.load(std::memory_order_relaxed));
+        }
+
+        void clear() {
+            for (std::atomic<std::uint64_t>& bucket : buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            count.store(0, std::memory_order_relaxed);
+            total.store(0, std::memory_order_relaxed);
+            max.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * The statistics recorded by a single thread.
+    */
+    struct ThreadStats {
+        std::array<ThreadHistogram, CheckoutStats::PhaseCount> latency;
+        std::array<std::atomic<std::uint64_t>, CheckoutStats::PhaseCount> allocations{};
+        ThreadHistogram cartAllocations;
+
+        /**
+         * Allocations made by phases since the last cart ended, only used by the owning thread.
+        */
+        std::uint64_t openCartAllocations = 0;
+    };
+
+    /**
+     * The statistics of every thread that has recorded anything, kept after the threads exit.
+    */
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<ThreadStats>> registry;
+
+    /**
+     * Gets the statistics of the calling thread, registering them on first use.
+    */
+    ThreadStats& threadStats() {
+        thread_local std::shared_ptr<ThreadStats> stats = []() {
+            auto created = std::make_shared<ThreadStats>();
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry.push_back(created);
+            return created;
+        }();
+        return *stats;
+    }
+
+#ifdef CHECKOUT_STATS
+    /**
+     * The heap allocations made by the calling thread, counted by the global operator new below.
+    */
+    thread_local std::uint64_t allocationCount = 0;
+#endif
+}
+
+#ifdef CHECKOUT_STATS
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#endif
+
+std::uint64_t CheckoutStats::Histogram::percentile(double percent) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    // Find the bucket holding the value of the requested rank
+    std::uint64_t rank = static_cast<std::uint64_t>(percent / 100 * (count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            std::uint64_t upperBound = b == 0 ? 0 : (b == 64 ? max : (std::uint64_t(1) << b) - 1);
+            return std::min(upperBound, max);
+        }
+    }
+    return max;
+}
+
+const char* CheckoutStats::phaseName(Phase phase) {
+    switch (phase) {
+        case ScanItem: return "scanItem";
+        case ScanBatch: return "scanBatch";
+        case RemoveItem: return "removeItem";
+        case CalculateDeals: return "calculateDeals";
+        case PrintReceipt: return "printReceipt";
+        case ClearSession: return "clearSession";
+        case LoadItems: return "readItemsFromFile";
+        case LoadDeals: return "readDealsFromFile";
+        case LoadSnapshot: return "loadSnapshot";
+        case JournalCommit: return "journalCommit";
+        case ReplayJournal: return "replayJournal";
+        default: return "unknown";
+    }
+}
+
+void CheckoutStats::record(Phase phase, std::uint64_t nanoseconds, std::uint64_t allocations) {
+    ThreadStats& stats = threadStats();
+    stats.latency[phase].record(nanoseconds);
+    ThreadHistogram::add(stats.allocations[phase], allocations);
+    stats.openCartAllocations += allocations;
+}
+
+void CheckoutStats::endCart() {
+    ThreadStats& stats = threadStats();
+    stats.cartAllocations.record(stats.openCartAllocations);
+    stats.openCartAllocations = 0;
+}
+
+std::uint64_t CheckoutStats::threadAllocations() {
+#ifdef CHECKOUT_STATS
+    return allocationCount;
+#else
+    return 0;
+#endif
+}
+
+CheckoutStats::Snapshot CheckoutStats::snapshot() {
+    Snapshot snapshot;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const std::shared_ptr<ThreadStats>& stats : registry) {
+        for (int phase = 0; phase < PhaseCount; phase++) {
+            stats->latency[phase].mergeInto(snapshot.latency[phase]);
+            snapshot.allocations[phase] += stats->allocations[phase].load(std::memory_order_relaxed);
+        }
+        stats->cartAllocations.mergeInto(snapshot.cartAllocations);
+    }
+    return snapshot;
+}
+
+void CheckoutStats::reset() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const std::shared_ptr<ThreadStats>& stats : registry) {
+        for (int phase = 0; phase < PhaseCount; phase++) {
+            stats->latency[phase].clear();
+            stats->allocations[phase].store(0, std::memory_order_relaxed);
+        }
+        stats->cartAllocations.clear();
+    }
+}
+
+void CheckoutStats::print(std::ostream& out) {
+    if (!isEnabled()) {
+        out << "Checkout statistics are not compiled in, rebuild with 'make STATS=1'." << std::endl;
+        return;
+    }
+    Snapshot snapshot = CheckoutStats::snapshot();
+
+    // Print a row of latencies per phase
+    out << std::left << std::setw(20) << "Phase" << std::right << std::setw(10) << "Calls"
+        << std::setw(12) << "Mean ns" << std::setw(12) << "p50 ns" << std::setw(12) << "p99 ns"
+        << std::setw(12) << "Max ns" << std::setw(12) << "Allocs" << std::endl;
+    for (int phase = 0; phase < PhaseCount; phase++) {
+        const Histogram& latency = snapshot.latency[phase];
+        if (latency.count == 0) {
+            continue;
+        }
+        out << std::left << std::setw(20) << phaseName(static_cast<Phase>(phase)) << std::right
+            << std::setw(10) << latency.count << std::setw(12) << latency.total / latency.count
+            << std::setw(12) << latency.percentile(50) << std::setw(12) << latency.percentile(99)
+            << std::setw(12) << latency.max << std::setw(12) << snapshot.allocations[phase] << std::endl;
+    }
+
+    // Print allocations per cart
+    const Histogram& carts = snapshot.cartAllocations;
+    if (carts.count > 0) {
+        out << "Allocations per cart: mean " << std::fixed << std::setprecision(1)
+            << static_cast<double>(carts.total) / carts.count << ", p50 " << carts.percentile(50)
+            << ", p99 " << carts.percentile(99) << ", max " << carts.max << " over " << carts.count
+            << " carts" << std::endl;
+    }
+}
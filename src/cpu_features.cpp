@@ -0,0 +1,10 @@
+#include "cpu_features.h"
+
+bool CpuFeatures::hasAvx2() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static const bool isSupported = __builtin_cpu_supports("avx2");
+    return isSupported;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,473 @@
+#include "deal_solver.h"
+
+#include <algorithm>
+#include <cmath>
+
+DealSolver::DealSolver(int nodeBudget) : nodeBudget(nodeBudget), catalog(nullptr), cluster(),
+    stateBound(0), nodes(0), isAborted(false), memoSlots(16, {0, -1}), memoStamp(0), result() {}
+
+void DealSolver::setNodeBudget(int nodeBudget) {
+    this->nodeBudget = nodeBudget;
+}
+
+const DealSolver::Result& DealSolver::solve(const Catalog& catalog, int clusterId, const int* quantities, DealPlan* plan) {
+    this->catalog = &catalog;
+    cluster = catalog.getDealCluster(clusterId);
+    int itemCount = cluster.itemIds.size();
+    state.assign(quantities, quantities + itemCount);
+    result = Result();
+
+    // A single deal is optimal in closed form
+    if (cluster.dealIds.size() == 1) {
+        result.savings = Money(applyDeal(0, state.data(), plan));
+        result.upperBound = result.savings;
+        result.isOptimal = true;
+        return result;
+    }
+
+    // Apply each deal greedily in turn, which is kept if the search cannot do better or runs out of budget
+    size_t firstRun = plan == nullptr ? 0 : plan->runs.size();
+    size_t firstSegment = plan == nullptr ? 0 : plan->segments.size();
+    std::int64_t greedySavings = 0;
+    for (size_t dealIndex = 0; dealIndex < cluster.dealIds.size(); ++dealIndex) {
+        greedySavings += applyDeal(dealIndex, state.data(), plan);
+    }
+    result.savings = Money(greedySavings);
+
+    // Bound the savings of the cart, and stop if the greedy groups reach it
+    prepareSearch();
+    long long units = 0;
+    stateBound = 0;
+    for (int slot = 0; slot < itemCount; ++slot) {
+        units += quantities[slot];
+        stateBound += quantities[slot] * unitBounds[slot];
+    }
+    result.upperBound = Money(static_cast<std::int64_t>(std::floor(stateBound + 0.5)));
+    if (greedySavings >= result.upperBound.getCents()) {
+        result.upperBound = result.savings;
+        result.isOptimal = true;
+        return result;
+    }
+    if (nodeBudget <= 0 || units > maxSearchUnits) {
+        return result;
+    }
+
+    // Start a new generation of the memo table
+    if (++memoStamp == 0) {
+        std::fill(memoSlots.begin(), memoSlots.end(), MemoSlot{0, -1});
+        memoStamp = 1;
+    }
+    memoKeys.clear();
+    memoHashes.clear();
+    memoValues.clear();
+    memoChoices.clear();
+    memoGroups.clear();
+
+    // Search from the cart's units, keeping the greedy groups if the budget runs out
+    state.assign(quantities, quantities + itemCount);
+    nodes = 0;
+    isAborted = false;
+    std::int64_t best = search(0);
+    result.nodes = nodes;
+    if (isAborted) {
+        return result;
+    }
+    result.savings = Money(best);
+    result.upperBound = result.savings;
+    result.isOptimal = true;
+
+    // Replace the greedy groups with the best groups
+    if (plan != nullptr) {
+        plan->runs.resize(firstRun);
+        plan->segments.resize(firstSegment);
+        reconstruct(quantities, *plan);
+    }
+    return result;
+}
+
+std::int64_t DealSolver::applyDeal(int dealIndex, int* remaining, DealPlan* plan) const {
+    int dealId = cluster.dealIds[dealIndex];
+    Deal deal = catalog->getDeal(dealId);
+    IdSpan slots = cluster.dealSlots(dealIndex);
+    IdSpan counts = cluster.dealSlotCounts(dealIndex);
+    int firstRun = plan == nullptr ? 0 : plan->runs.size();
+    std::int64_t savings = 0;
+
+    if (deal.type == DealType::Bundle) {
+        // Form as many bundles as the scarcest item allows
+        long long bundles = -1;
+        std::int64_t bundleSavings = -deal.bundlePrice.getCents();
+        for (size_t i = 0; i < slots.size(); ++i) {
+            long long available = remaining[slots[i]] / counts[i];
+            bundles = bundles == -1 ? available : std::min(bundles, available);
+            bundleSavings += catalog->getItemPrices()[cluster.itemIds[slots[i]]] * counts[i];
+        }
+        if (bundles <= 0 || bundleSavings <= 0) {
+            return 0;
+        }
+        for (size_t i = 0; i < slots.size(); ++i) {
+            remaining[slots[i]] -= bundles * counts[i];
+            if (plan != nullptr) {
+                plan->runs.push_back({cluster.itemIds[slots[i]], counts[i]});
+            }
+        }
+        if (plan != nullptr) {
+            plan->segments.push_back({dealId, firstRun, static_cast<int>(slots.size()), static_cast<int>(bundles)});
+        }
+        return bundleSavings * bundles;
+    }
+
+    // Count units of deal items. Since the items are sorted by price, greedily forming groups of
+    // the most expensive units means the first (units - units % groupSize) units in price order are
+    // grouped, and the last freeCount units of every group are free.
+    long long groupSize = deal.groupSize();
+    long long units = 0;
+    for (int slot : slots) {
+        units += remaining[slot];
+    }
+    long long groupedUnits = units - units % groupSize;
+    if (groupedUnits == 0) {
+        return 0;
+    }
+
+    // Counts the free units among the first units in price order
+    auto freeUnitsBefore = [&deal, groupSize](long long units) {
+        return units / groupSize * deal.freeCount + std::max(0LL, units % groupSize - deal.buyCount);
+    };
+
+    // Iterate over deal items, tracking the offset of each item's first unit
+    long long offset = 0;
+    for (int slot : slots) {
+        // Stop once all grouped units are assigned
+        if (offset >= groupedUnits) {
+            break;
+        }
+        int quantity = remaining[slot];
+        if (quantity == 0) {
+            continue;
+        }
+
+        // Find how many units of the item are grouped, and how many of those are free
+        long long end = std::min(offset + quantity, groupedUnits);
+        int grouped = end - offset;
+        savings += catalog->getItemPrices()[cluster.itemIds[slot]] * (freeUnitsBefore(end) - freeUnitsBefore(offset));
+        remaining[slot] -= grouped;
+        if (plan != nullptr) {
+            plan->runs.push_back({cluster.itemIds[slot], grouped});
+        }
+        offset = end;
+    }
+    if (plan != nullptr) {
+        plan->segments.push_back({dealId, firstRun, static_cast<int>(plan->runs.size()) - firstRun, 1});
+    }
+    return savings;
+}
+
+void DealSolver::prepareSearch() {
+    int itemCount = cluster.itemIds.size();
+    prices.resize(itemCount);
+    for (int slot = 0; slot < itemCount; ++slot) {
+        prices[slot] = catalog->getItemPrices()[cluster.itemIds[slot]];
+    }
+
+    // List the deals containing each item
+    slotDealOffsets.assign(itemCount + 1, 0);
+    for (size_t dealIndex = 0; dealIndex < cluster.dealIds.size(); ++dealIndex) {
+        for (int slot : cluster.dealSlots(dealIndex)) {
+            slotDealOffsets[slot + 1]++;
+        }
+    }
+    for (int slot = 0; slot < itemCount; ++slot) {
+        slotDealOffsets[slot + 1] += slotDealOffsets[slot];
+    }
+    slotDeals.resize(slotDealOffsets[itemCount]);
+    slotDealCursors.assign(slotDealOffsets.begin(), slotDealOffsets.end() - 1);
+    for (size_t dealIndex = 0; dealIndex < cluster.dealIds.size(); ++dealIndex) {
+        for (int slot : cluster.dealSlots(dealIndex)) {
+            slotDeals[slotDealCursors[slot]++] = dealIndex;
+        }
+    }
+
+    // Bound the savings each unit can contribute by sharing the savings of a group equally among
+    // its units: the freeCount cheapest units of a group of groupSize units are worth at most
+    // freeCount / groupSize of the whole group, and a bundle's savings are shared over its units
+    unitBounds.assign(itemCount, 0);
+    bundleSavings.assign(cluster.dealIds.size(), 0);
+    for (size_t dealIndex = 0; dealIndex < cluster.dealIds.size(); ++dealIndex) {
+        Deal deal = catalog->getDeal(cluster.dealIds[dealIndex]);
+        IdSpan slots = cluster.dealSlots(dealIndex);
+        IdSpan counts = cluster.dealSlotCounts(dealIndex);
+        if (deal.type == DealType::Bundle) {
+            std::int64_t savings = -deal.bundlePrice.getCents();
+            for (size_t i = 0; i < slots.size(); ++i) {
+                savings += prices[slots[i]] * counts[i];
+            }
+            bundleSavings[dealIndex] = savings;
+            for (int slot : slots) {
+                unitBounds[slot] = std::max(unitBounds[slot], static_cast<double>(savings) / deal.groupSize());
+            }
+        } else {
+            for (int slot : slots) {
+                unitBounds[slot] = std::max(unitBounds[slot], static_cast<double>(prices[slot]) * deal.freeCount / deal.groupSize());
+            }
+        }
+    }
+}
+
+std::int64_t DealSolver::search(int top) {
+    // Find the most expensive remaining item
+    int itemCount = state.size();
+    while (top < itemCount && state[top] == 0) {
+        top++;
+    }
+    if (top == itemCount) {
+        return 0;
+    }
+
+    // Return the savings of states that have already been explored
+    std::uint64_t hash = hashState();
+    int entry = findMemo(hash);
+    if (entry != -1) {
+        return memoValues[entry];
+    }
+    if (++nodes > nodeBudget) {
+        isAborted = true;
+        return 0;
+    }
+
+    // Leave one unit of the item out of every group
+    state[top]--;
+    stateBound -= unitBounds[top];
+    std::int64_t best = search(top);
+    state[top]++;
+    stateBound += unitBounds[top];
+    int bestDeal = -1;
+    int bestPicks[Deal::maxGroupSize];
+    int picks[Deal::maxGroupSize];
+
+    // Or add the unit to a group of each deal containing the item
+    for (int i = slotDealOffsets[top]; i < slotDealOffsets[top + 1] && !isAborted; ++i) {
+        int dealIndex = slotDeals[i];
+        IdSpan slots = cluster.dealSlots(dealIndex);
+        if (catalog->getDeal(cluster.dealIds[dealIndex]).type == DealType::BuyGetFree) {
+            std::int64_t previousBest = best;
+            state[top]--;
+            stateBound -= unitBounds[top];
+            searchGroups(dealIndex, top, picks, 0, std::lower_bound(slots.begin(), slots.end(), top) - slots.begin(), best, bestPicks);
+            state[top]++;
+            stateBound += unitBounds[top];
+            if (best > previousBest) {
+                bestDeal = dealIndex;
+            }
+            continue;
+        }
+
+        // A bundle needs all of its units, and is only worth forming if it saves money
+        IdSpan counts = cluster.dealSlotCounts(dealIndex);
+        bool isAvailable = bundleSavings[dealIndex] > 0;
+        for (size_t j = 0; j < slots.size() && isAvailable; ++j) {
+            isAvailable = state[slots[j]] >= counts[j];
+        }
+        if (!isAvailable) {
+            continue;
+        }
+        for (size_t j = 0; j < slots.size(); ++j) {
+            state[slots[j]] -= counts[j];
+            stateBound -= unitBounds[slots[j]] * counts[j];
+        }
+        std::int64_t savings = bundleSavings[dealIndex];
+        if (savings + stateBound >= best + 0.5) {
+            savings += search(top);
+            if (savings > best) {
+                best = savings;
+                bestDeal = dealIndex;
+            }
+        }
+        for (size_t j = 0; j < slots.size(); ++j) {
+            state[slots[j]] += counts[j];
+            stateBound += unitBounds[slots[j]] * counts[j];
+        }
+    }
+    if (isAborted) {
+        return 0;
+    }
+
+    // Remember the best choice
+    int choice = -1;
+    if (bestDeal != -1) {
+        choice = memoGroups.size();
+        memoGroups.push_back(bestDeal);
+        if (catalog->getDeal(cluster.dealIds[bestDeal]).type == DealType::BuyGetFree) {
+            int groupSize = catalog->getDeal(cluster.dealIds[bestDeal]).groupSize();
+            memoGroups.insert(memoGroups.end(), bestPicks, bestPicks + groupSize - 1);
+        }
+    }
+    addMemo(hash, best, choice);
+    return best;
+}
+
+void DealSolver::searchGroups(int dealIndex, int top, int* picks, int pickCount, size_t listPos,
+                              std::int64_t& best, int* bestPicks) {
+    Deal deal = catalog->getDeal(cluster.dealIds[dealIndex]);
+    int groupSize = deal.groupSize();
+
+    if (pickCount == groupSize - 1) {
+        // The group is complete. Its units are in price order, so the last freeCount are free.
+        std::int64_t savings = 0;
+        for (int i = groupSize - 1 - deal.freeCount; i < groupSize - 1; ++i) {
+            savings += prices[picks[i]];
+        }
+        if (savings + stateBound < best + 0.5) {
+            return;
+        }
+        savings += search(top);
+        if (savings > best) {
+            best = savings;
+            std::copy(picks, picks + pickCount, bestPicks);
+        }
+        return;
+    }
+
+    // Choose the next unit from the same or a cheaper item than the previous unit
+    IdSpan slots = cluster.dealSlots(dealIndex);
+    for (size_t i = listPos; i < slots.size() && !isAborted; ++i) {
+        int slot = slots[i];
+        if (state[slot] == 0) {
+            continue;
+        }
+        picks[pickCount] = slot;
+        state[slot]--;
+        stateBound -= unitBounds[slot];
+        searchGroups(dealIndex, top, picks, pickCount + 1, i, best, bestPicks);
+        state[slot]++;
+        stateBound += unitBounds[slot];
+    }
+}
+
+void DealSolver::reconstruct(const int* quantities, DealPlan& plan) {
+    int itemCount = cluster.itemIds.size();
+    state.assign(quantities, quantities + itemCount);
+    size_t firstSegment = plan.segments.size();
+    int slots[Deal::maxGroupSize];
+
+    // Follow the best choice of each state from the starting state, all of which were explored
+    int top = 0;
+    while (true) {
+        while (top < itemCount && state[top] == 0) {
+            top++;
+        }
+        if (top == itemCount) {
+            return;
+        }
+        int choice = memoChoices[findMemo(hashState())];
+        if (choice == -1) {
+            state[top]--;
+            continue;
+        }
+
+        // Gather the units of the group in price order
+        int dealIndex = memoGroups[choice];
+        int count = 0;
+        if (catalog->getDeal(cluster.dealIds[dealIndex]).type == DealType::BuyGetFree) {
+            int groupSize = catalog->getDeal(cluster.dealIds[dealIndex]).groupSize();
+            slots[count++] = top;
+            for (int i = 0; i < groupSize - 1; ++i) {
+                slots[count++] = memoGroups[choice + 1 + i];
+            }
+        } else {
+            IdSpan dealSlots = cluster.dealSlots(dealIndex);
+            IdSpan counts = cluster.dealSlotCounts(dealIndex);
+            for (size_t i = 0; i < dealSlots.size(); ++i) {
+                for (int unit = 0; unit < counts[i]; ++unit) {
+                    slots[count++] = dealSlots[i];
+                }
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            state[slots[i]]--;
+        }
+        addGroup(dealIndex, slots, count, firstSegment, plan);
+    }
+}
+
+void DealSolver::addGroup(int dealIndex, const int* slots, int count, size_t firstSegment, DealPlan& plan) const {
+    int dealId = cluster.dealIds[dealIndex];
+    int firstRun = plan.runs.size();
+
+    // Add runs of consecutive units of the same item
+    for (int i = 0; i < count; ++i) {
+        int itemId = cluster.itemIds[slots[i]];
+        if (plan.runs.size() > static_cast<size_t>(firstRun) && plan.runs.back().itemId == itemId) {
+            plan.runs.back().quantity++;
+        } else {
+            plan.runs.push_back({itemId, 1});
+        }
+    }
+    int runCount = plan.runs.size() - firstRun;
+
+    // Repeat the previous segment instead if it is the same group
+    if (plan.segments.size() > firstSegment) {
+        DealPlan::Segment& previous = plan.segments.back();
+        if (previous.dealId == dealId && previous.runCount == runCount) {
+            bool isSame = true;
+            for (int i = 0; i < runCount && isSame; ++i) {
+                const DealPlan::Run& run1 = plan.runs[previous.firstRun + i];
+                const DealPlan::Run& run2 = plan.runs[firstRun + i];
+                isSame = run1.itemId == run2.itemId && run1.quantity == run2.quantity;
+            }
+            if (isSame) {
+                previous.repeat++;
+                plan.runs.resize(firstRun);
+                return;
+            }
+        }
+    }
+    plan.segments.push_back({dealId, firstRun, runCount, 1});
+}
+
+std::uint64_t DealSolver::hashState() const {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (int units : state) {
+        hash = (hash ^ static_cast<std::uint32_t>(units)) * 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+int DealSolver::findMemo(std::uint64_t hash) const {
+    size_t mask = memoSlots.size() - 1;
+    size_t itemCount = state.size();
+    for (size_t slot = hash & mask; memoSlots[slot].stamp == memoStamp; slot = (slot + 1) & mask) {
+        int entry = memoSlots[slot].entry;
+        if (memoHashes[entry] == hash && std::equal(state.begin(), state.end(), memoKeys.begin() + entry * itemCount)) {
+            return entry;
+        }
+    }
+    return -1;
+}
+
+void DealSolver::addMemo(std::uint64_t hash, std::int64_t value, int choice) {
+    int entry = memoValues.size();
+    memoKeys.insert(memoKeys.end(), state.begin(), state.end());
+    memoHashes.push_back(hash);
+    memoValues.push_back(value);
+    memoChoices.push_back(choice);
+
+    // Grow the table once it is more than half full, reinserting the entries of this solve
+    size_t mask = memoSlots.size() - 1;
+    if (memoValues.size() * 2 > memoSlots.size()) {
+        memoSlots.assign(memoSlots.size() * 2, {0, -1});
+        mask = memoSlots.size() - 1;
+        for (int other = 0; other < entry; ++other) {
+            size_t slot = memoHashes[other] & mask;
+            while (memoSlots[slot].stamp == memoStamp) {
+                slot = (slot + 1) & mask;
+            }
+            memoSlots[slot] = {memoStamp, other};
+        }
+    }
+    size_t slot = hash & mask;
+    while (memoSlots[slot].stamp == memoStamp) {
+        slot = (slot + 1) & mask;
+    }
+    memoSlots[slot] = {memoStamp, entry};
+}
@@ -0,0 +1,26 @@
+#include "id_bitmap.h"
+
+IdBitmap::IdBitmap() : setSummaryCount(0), count(0) {}
+
+void IdBitmap::resize(size_t capacity) {
+    size_t wordCount = (capacity + wordBits - 1) / wordBits;
+    words.assign(wordCount, 0);
+    summary.assign((wordCount + wordBits - 1) / wordBits, 0);
+    setSummaryIndexes.assign(summary.size() + 1, 0);
+    setSummaryCount = 0;
+    count = 0;
+}
+
+void IdBitmap::clear() {
+    // Zero the words marked in each non-zero summary word, then the summary word itself, leaving the
+    // summary words that were never set untouched
+    for (size_t stackIndex = 0; stackIndex < setSummaryCount; ++stackIndex) {
+        std::uint32_t summaryIndex = setSummaryIndexes[stackIndex];
+        for (std::uint64_t wordsLeft = summary[summaryIndex]; wordsLeft != 0; wordsLeft &= wordsLeft - 1) {
+            words[summaryIndex * wordBits + lowestBit(wordsLeft)] = 0;
+        }
+        summary[summaryIndex] = 0;
+    }
+    setSummaryCount = 0;
+    count = 0;
+}
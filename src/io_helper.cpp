@@ -1,57 +1,267 @@
 #include "io_helper.h"
+#include "cpu_features.h"
+
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IO_HELPER_AVX2
+#include <immintrin.h>
+#endif
+#ifdef __SSE2__
+#define IO_HELPER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    /**
+     * Converts bytes to Camel Case one at a time, capitalizing the first byte of each word.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @param capitalizeNext Whether the first byte starts a word.
+     * @returns Whether the byte after the last starts a word.
+    */
+    bool camelCaseBytes(char* data, size_t size, bool capitalizeNext) {
+        for (size_t i = 0; i < size; ++i) {
+            unsigned char c = data[i];
+            if (std::isspace(c)) {
+                // Set flag to capitalize after space
+                capitalizeNext = true;
+
+            } else if (capitalizeNext) {
+
+                // Capitalize current character
+                data[i] = std::toupper(c);
+
+                // Reset flag
+                capitalizeNext = false;
+            } else {
+                // Lowercase current character
+                data[i] = std::tolower(c);
+            }
+        }
+        return capitalizeNext;
+    }
+
+#ifdef IO_HELPER_SSE2
+    /**
+     * Converts bytes to Camel Case 16 at a time. Bytes that start a word, which follow a space of
+     * the C locale, have their case flipped if lowercase, and other bytes if uppercase. Blocks
+     * holding non-ASCII bytes are converted by camelCaseBytes, and the last partial block is
+     * converted padded with zeros, which are neither spaces nor letters.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @param capitalizeNext Whether the first byte starts a word.
+    */
+    void camelCaseSse2(char* data, size_t size, bool capitalizeNext) {
+        static const __m128i space = _mm_set1_epi8(' ');
+        static const __m128i beforeTab = _mm_set1_epi8('\t' - 1);
+        static const __m128i afterReturn = _mm_set1_epi8('\r' + 1);
+        static const __m128i beforeUpper = _mm_set1_epi8('A' - 1);
+        static const __m128i afterUpper = _mm_set1_epi8('Z' + 1);
+        static const __m128i beforeLower = _mm_set1_epi8('a' - 1);
+        static const __m128i afterLower = _mm_set1_epi8('z' + 1);
+        static const __m128i caseBit = _mm_set1_epi8(0x20);
+        for (size_t pos = 0; pos < size; pos += 16) {
+            // Load the next block, copying a partial last block into zeros
+            alignas(16) char padded[16] = {};
+            size_t blockSize = std::min<size_t>(16, size - pos);
+            char* block = data + pos;
+            if (blockSize < 16) {
+                std::memcpy(padded, block, blockSize);
+                block = padded;
+            }
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+            if (_mm_movemask_epi8(bytes) != 0) {
+                capitalizeNext = camelCaseBytes(data + pos, blockSize, capitalizeNext);
+                continue;
+            }
+
+            // Find spaces, which are ' ' and '\t' to '\r', and shift them one byte on to find word starts
+            __m128i isSpace = _mm_or_si128(_mm_cmpeq_epi8(bytes, space),
+                _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeTab), _mm_cmplt_epi8(bytes, afterReturn)));
+            __m128i isWordStart = _mm_or_si128(_mm_slli_si128(isSpace, 1), _mm_cvtsi32_si128(capitalizeNext ? 0xFF : 0));
+
+            // Flip the case of lowercase word starts and uppercase letters elsewhere
+            __m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeUpper), _mm_cmplt_epi8(bytes, afterUpper));
+            __m128i isLower = _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeLower), _mm_cmplt_epi8(bytes, afterLower));
+            __m128i flip = _mm_or_si128(_mm_and_si128(isWordStart, isLower), _mm_andnot_si128(isWordStart, isUpper));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(block), _mm_xor_si128(bytes, _mm_and_si128(flip, caseBit)));
+            if (block == padded) {
+                std::memcpy(data + pos, padded, blockSize);
+            }
+
+            capitalizeNext = (_mm_movemask_epi8(isSpace) >> 15) & 1;
+        }
+    }
+#endif
+
+#ifdef IO_HELPER_AVX2
+    /**
+     * Converts whole blocks of 32 bytes to Camel Case like camelCaseSse2, leaving the last partial
+     * block. Only call if CpuFeatures::hasAvx2() is true.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @param capitalizeNext Whether the first byte starts a word, set to whether the byte after the
+     * last converted block does.
+     * @returns The number of bytes converted.
+    */
+    __attribute__((target("avx2")))
+    size_t camelCaseAvx2(char* data, size_t size, bool& capitalizeNext) {
+        static const __m256i space = _mm256_set1_epi8(' ');
+        static const __m256i beforeTab = _mm256_set1_epi8('\t' - 1);
+        static const __m256i afterReturn = _mm256_set1_epi8('\r' + 1);
+        static const __m256i beforeUpper = _mm256_set1_epi8('A' - 1);
+        static const __m256i afterUpper = _mm256_set1_epi8('Z' + 1);
+        static const __m256i beforeLower = _mm256_set1_epi8('a' - 1);
+        static const __m256i afterLower = _mm256_set1_epi8('z' + 1);
+        static const __m256i caseBit = _mm256_set1_epi8(0x20);
+        size_t pos = 0;
+        for (; pos + 32 <= size; pos += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            if (_mm256_movemask_epi8(bytes) != 0) {
+                capitalizeNext = camelCaseBytes(data + pos, 32, capitalizeNext);
+                continue;
+            }
+
+            // Find spaces, and shift them one byte on across the two 128 bit lanes to find word starts
+            __m256i isSpace = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, space),
+                _mm256_and_si256(_mm256_cmpgt_epi8(bytes, beforeTab), _mm256_cmpgt_epi8(afterReturn, bytes)));
+            __m256i shifted = _mm256_alignr_epi8(isSpace, _mm256_permute2x128_si256(isSpace, isSpace, 0x08), 15);
+            __m256i isWordStart = _mm256_or_si256(shifted, _mm256_set_epi64x(0, 0, 0, capitalizeNext ? 0xFF : 0));
+
+            // Flip the case of lowercase word starts and uppercase letters elsewhere
+            __m256i isUpper = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, beforeUpper), _mm256_cmpgt_epi8(afterUpper, bytes));
+            __m256i isLower = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, beforeLower), _mm256_cmpgt_epi8(afterLower, bytes));
+            __m256i flip = _mm256_or_si256(_mm256_and_si256(isWordStart, isLower), _mm256_andnot_si256(isWordStart, isUpper));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + pos), _mm256_xor_si256(bytes, _mm256_and_si256(flip, caseBit)));
+
+            capitalizeNext = (static_cast<unsigned int>(_mm256_movemask_epi8(isSpace)) >> 31) & 1;
+        }
+        return pos;
+    }
+#endif
+}
 
 void IOHelper::printCentered(const std::string& str, int totalWidth, std::ostream& out) {
     // If string is longer than width, just print string
     if (str.length() >= totalWidth) {
-        out << str << std::endl;
+        out << str << '\n';
     }
     
     // Calculate left padding
-    int padding = (totalWidth - str.length()) / 2;
+    int padding = (totalWidth - static_cast<int>(str.length())) / 2;
     // Print padding spaces and string
-    out << std::string(padding, ' ') << str << std::endl;
+    std::fill_n(std::ostreambuf_iterator<char>(out), std::max(padding, 0), ' ');
+    out << str << '\n';
 }
 
 void IOHelper::printSolidLine(int length, std::ostream& out) {
-    out << std::string(length, '-') << std::endl;
+    std::fill_n(std::ostreambuf_iterator<char>(out), length, '-');
+    out << '\n';
 }
 
 void IOHelper::printDashedLine(int length, std::ostream& out) {
     int iters = length / 2;
     for (int i = 0; i < iters; ++i) {
-        out << "- ";
+        out.write("- ", 2);
     }
-    out << std::endl;
+    out << '\n';
 }
 
 void IOHelper::toCamelCase(std::string& str) {
-    // Capitalize first character
-    bool capitalizeNext = true;  
-    for (int i = 0; i < str.size(); ++i) {
-        if (std::isspace(str[i])) {
-            // Set flag to capitalize after space
-            capitalizeNext = true; 
-
-        } else if (capitalizeNext) {
-
-            // Capitalize current character
-            str[i] = std::toupper(str[i]);
-
-            // Reset flag
-            capitalizeNext = false; 
-        } else {
-            // Lowercase current character
-            str[i] = std::tolower(str[i]); 
+    char* data = str.data();
+    size_t size = str.size();
+    size_t pos = 0;
+
+    // Capitalize first character, and convert whole blocks with the widest instructions supported
+    bool capitalizeNext = true;
+#ifdef IO_HELPER_AVX2
+    if (size >= 32 && CpuFeatures::hasAvx2()) {
+        pos = camelCaseAvx2(data, size, capitalizeNext);
+    }
+#endif
+#ifdef IO_HELPER_SSE2
+    camelCaseSse2(data + pos, size - pos, capitalizeNext);
+#else
+    camelCaseBytes(data + pos, size - pos, capitalizeNext);
+#endif
+}
+
+void IOHelper::toCamelCaseScalar(std::string& str) {
+    camelCaseBytes(str.data(), str.size(), true);
+}
+
+bool IOHelper::nextField(std::string_view str, size_t& pos, char delimiter, std::string_view& field) {
+    if (pos >= str.size()) {
+        return false;
+    }
+    size_t end = str.find(delimiter, pos);
+    if (end == std::string_view::npos) {
+        end = str.size();
+    }
+    field = str.substr(pos, end - pos);
+    pos = end + 1;
+    return true;
+}
+
+bool IOHelper::nextWord(std::string_view str, size_t& pos, std::string_view& word) {
+    // Skip whitespace before the word
+    while (pos < str.size() && std::isspace(static_cast<unsigned char>(str[pos]))) {
+        pos++;
+    }
+    if (pos >= str.size()) {
+        return false;
+    }
+
+    // Read up to the next whitespace
+    size_t end = pos;
+    while (end < str.size() && !std::isspace(static_cast<unsigned char>(str[end]))) {
+        end++;
+    }
+    word = str.substr(pos, end - pos);
+    pos = end;
+    return true;
+}
+
+IOHelper::ParseStatus IOHelper::parseInt(std::string_view str, int& value) {
+    // Skip leading whitespace and a plus sign, which std::stoi accepts but std::from_chars does not
+    size_t pos = 0;
+    while (pos < str.size() && std::isspace(static_cast<unsigned char>(str[pos]))) {
+        pos++;
+    }
+    if (pos < str.size() && str[pos] == '+') {
+        pos++;
+        if (pos == str.size() || str[pos] == '-') {
+            return ParseStatus::Invalid;
         }
     }
+
+    // Parse the number, which must reach the end of the string
+    const char* end = str.data() + str.size();
+    std::from_chars_result result = std::from_chars(str.data() + pos, end, value);
+    if (result.ec == std::errc::result_out_of_range) {
+        return ParseStatus::OutOfRange;
+    }
+    if (result.ec != std::errc() || result.ptr != end) {
+        return ParseStatus::Invalid;
+    }
+    return ParseStatus::Ok;
 }
 
 int IOHelper::fullStoi(const std::string& str) {
-    std::size_t pos = 0;
-    int num = std::stoi(str, &pos);
+    int num;
+    ParseStatus status = parseInt(str, num);
+    if (status == ParseStatus::OutOfRange) {
+        throw std::out_of_range("String '" + str + "' is out of range of an int.");
+    }
 
     // Check if string was not fully parsed due to non numeric characters
-    if (pos != str.length()) {
+    if (status != ParseStatus::Ok) {
         throw std::invalid_argument("String '" + str + "' cannot be converted to an int.");
     }
     return num;
@@ -0,0 +1,287 @@
+#include "journal.h"
+#include "mapped_file.h"
+#include "checkout_stats.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    /**
+     * The size of the length and checksum fields at the start of every record.
+    */
+    const size_t headerSize = 8;
+
+    /**
+     * The size of a record after its header, excluding the item name bytes.
+    */
+    const size_t fixedPayloadSize = 11;
+
+    /**
+     * Appends an unsigned integer in little endian byte order.
+     * @param buffer The buffer.
+     * @param value The integer.
+     * @param bytes The number of bytes to write.
+    */
+    void appendInteger(std::string& buffer, std::uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    /**
+     * Reads an unsigned integer in little endian byte order.
+     * @param data The first byte of the integer.
+     * @param bytes The number of bytes to read.
+     * @returns The integer.
+    */
+    std::uint64_t readInteger(const char* data, int bytes) {
+        std::uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    /**
+     * Computes the 32 bit FNV-1a hash of bytes, which detects records torn by a crash.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @returns The hash.
+    */
+    std::uint32_t checksum(const char* data, size_t size) {
+        std::uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    /**
+     * Creates an empty file to append to, replacing any file at the path.
+     * @param filepath The path.
+     * @returns The descriptor, or -1 if the file cannot be created.
+    */
+    int createFile(const std::string& filepath) {
+#ifdef _WIN32
+        return ::_open(filepath.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        return ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+#endif
+    }
+
+    /**
+     * Writes all bytes to a file and syncs them to disk.
+     * @param fd The descriptor of the file.
+     * @param data The bytes.
+     * @returns Whether all bytes were written and synced.
+    */
+    bool writeDurably(int fd, const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+#ifdef _WIN32
+            int result = ::_write(fd, data.data() + written, static_cast<unsigned int>(data.size() - written));
+#else
+            ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+#endif
+            if (result <= 0) {
+                return false;
+            }
+            written += result;
+        }
+#if defined(_WIN32)
+        return ::_commit(fd) == 0;
+#elif defined(__linux__)
+        return ::fdatasync(fd) == 0;
+#else
+        return ::fsync(fd) == 0;
+#endif
+    }
+
+    /**
+     * Syncs a directory, so a file moved into it survives a crash. Not needed on Windows.
+     * @param directory The path of the directory.
+    */
+    void syncDirectory(const std::filesystem::path& directory) {
+#ifndef _WIN32
+        int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+        if (fd != -1) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+#endif
+    }
+}
+
+Journal::Journal(const std::string& filepath) : filepath(filepath), pendingPath(filepath + ".new"), appendedCount(0),
+    durableCount(0), commitCount(0), isFailed(false), isClosing(false) {
+    fd = createFile(pendingPath);
+    if (fd == -1) {
+        throw std::runtime_error("Cannot create journal file: '" + pendingPath + "'.");
+    }
+    commitThread = std::thread(&Journal::runCommits, this);
+}
+
+Journal::~Journal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isClosing = true;
+    }
+    appended.notify_one();
+    commitThread.join();
+#ifdef _WIN32
+    ::_close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+std::uint64_t Journal::append(JournalEventType type, std::uint32_t registerId, std::string_view itemName, int quantity) {
+    size_t nameLength = std::min<size_t>(itemName.size(), 0xFFFF);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::uint64_t sequence = ++appendedCount;
+    if (isFailed) {
+        return sequence;
+    }
+    bool wasEmpty = buffer.empty();
+
+    // Encode the record after a header for its length and checksum, filled in once it is encoded
+    size_t start = buffer.size();
+    buffer.append(headerSize, '\0');
+    appendInteger(buffer, static_cast<std::uint8_t>(type), 1);
+    appendInteger(buffer, registerId, 4);
+    appendInteger(buffer, static_cast<std::uint32_t>(quantity), 4);
+    appendInteger(buffer, nameLength, 2);
+    buffer.append(itemName.data(), nameLength);
+
+    std::uint64_t length = fixedPayloadSize + nameLength;
+    std::uint32_t hash = checksum(buffer.data() + start + headerSize, length);
+    for (int i = 0; i < 4; i++) {
+        buffer[start + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+        buffer[start + 4 + i] = static_cast<char>((hash >> (8 * i)) & 0xFF);
+    }
+
+    // The commit thread only sleeps while the buffer is empty
+    if (wasEmpty) {
+        appended.notify_one();
+    }
+    return sequence;
+}
+
+bool Journal::waitUntilDurable(std::uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex);
+    committed.wait(lock, [this, sequence]() { return durableCount >= sequence || isFailed; });
+    return durableCount >= sequence;
+}
+
+void Journal::publish() {
+    std::uint64_t sequence;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sequence = appendedCount;
+    }
+    if (!waitUntilDurable(sequence)) {
+        throw std::runtime_error("Cannot write journal file: '" + pendingPath + "'.");
+    }
+
+    // Replace the previous log, which stays complete until the rename
+    std::error_code error;
+    std::filesystem::rename(pendingPath, filepath, error);
+    if (error) {
+        throw std::runtime_error("Cannot replace journal file: '" + filepath + "': " + error.message());
+    }
+    syncDirectory(std::filesystem::path(filepath).parent_path());
+}
+
+std::uint64_t Journal::getCommitCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return commitCount;
+}
+
+void Journal::runCommits() {
+    std::string writing;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        appended.wait(lock, [this]() { return !buffer.empty() || isClosing; });
+        if (buffer.empty()) {
+            return;
+        }
+
+        // Take every record appended so far, leaving an empty buffer with the capacity of the last
+        // one so appends can continue while this group is written
+        writing.swap(buffer);
+        std::uint64_t groupEnd = appendedCount;
+        lock.unlock();
+
+        bool isWritten;
+        {
+            CHECKOUT_STATS_PHASE(JournalCommit);
+            isWritten = writeDurably(fd, writing);
+        }
+        writing.clear();
+
+        lock.lock();
+        commitCount++;
+        if (isWritten) {
+            durableCount = groupEnd;
+        } else if (!isFailed) {
+            // Stop journaling rather than stopping the registers, which keep working without it
+            isFailed = true;
+            buffer.clear();
+            std::cerr << "Error: " << "Cannot write journal file: '" << pendingPath << "'. Carts are no longer journaled." << std::endl;
+        }
+        committed.notify_all();
+    }
+}
+
+size_t Journal::replay(const std::string& filepath, const std::function<void(const JournalEvent&)>& apply) {
+    CHECKOUT_STATS_PHASE(ReplayJournal);
+
+    MappedFile file(filepath);
+    if (!file.isOpen()) {
+        return 0;
+    }
+    std::string_view contents = file.contents();
+
+    // Read records until the end of the file or the first record that was not fully written
+    size_t events = 0;
+    size_t pos = 0;
+    while (contents.size() - pos >= headerSize + fixedPayloadSize) {
+        const char* record = contents.data() + pos;
+        std::uint64_t length = readInteger(record, 4);
+        if (length < fixedPayloadSize || length > contents.size() - pos - headerSize) {
+            break;
+        }
+        const char* payload = record + headerSize;
+        if (checksum(payload, length) != readInteger(record + 4, 4)) {
+            break;
+        }
+        size_t nameLength = readInteger(payload + 9, 2);
+        if (fixedPayloadSize + nameLength != length) {
+            break;
+        }
+
+        JournalEvent event;
+        event.type = static_cast<JournalEventType>(payload[0]);
+        event.registerId = readInteger(payload + 1, 4);
+        event.quantity = static_cast<std::int32_t>(readInteger(payload + 5, 4));
+        event.itemName = std::string_view(payload + fixedPayloadSize, nameLength);
+        apply(event);
+
+        events++;
+        pos += headerSize + length;
+    }
+    return events;
+}
@@ -0,0 +1,103 @@
+#include "json_receipt_sink.h"
+
+namespace {
+    /**
+     * Appends a string as a JSON string literal, escaping quotes, backslashes and control characters.
+     * @param writer The writer.
+     * @param str The string.
+    */
+    void appendJsonString(ReceiptWriter& writer, std::string_view str) {
+        static const char hexDigits[] = "0123456789abcdef";
+        writer.append("\"");
+        size_t runStart = 0;
+        for (size_t i = 0; i < str.size(); i++) {
+            unsigned char c = str[i];
+            if (c != '"' && c != '\\' && c >= 0x20) {
+                continue;
+            }
+
+            // Flush the unescaped run before the character, then escape it
+            writer.append(str.substr(runStart, i - runStart));
+            runStart = i + 1;
+            if (c == '"' || c == '\\') {
+                char escaped[2] = {'\\', static_cast<char>(c)};
+                writer.append(std::string_view(escaped, 2));
+            } else {
+                char escaped[6] = {'\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF]};
+                writer.append(std::string_view(escaped, 6));
+            }
+        }
+        writer.append(str.substr(runStart));
+        writer.append("\"");
+    }
+
+    /**
+     * Appends a receipt line as a JSON object.
+     * @param writer The writer.
+     * @param line The line.
+     * @param isDealLine Whether to include the free field of deal lines.
+    */
+    void appendJsonLine(ReceiptWriter& writer, const ReceiptLine& line, bool isDealLine) {
+        writer.append("{\"item\":");
+        appendJsonString(writer, line.name);
+        writer.append(",\"quantity\":");
+        writer.append(static_cast<long long>(line.quantity));
+        writer.append(",\"price_cents\":");
+        writer.append(static_cast<long long>(line.price.getCents()));
+        if (isDealLine) {
+            writer.append(line.isFree ? ",\"free\":true" : ",\"free\":false");
+        }
+        writer.append("}");
+    }
+}
+
+JsonReceiptSink::JsonReceiptSink(std::ostream& out) : out(out) {}
+
+void JsonReceiptSink::write(const Receipt& receipt) {
+    writer.append("{");
+    if (receipt.cartId >= 0) {
+        writer.append("\"cart\":");
+        writer.append(static_cast<long long>(receipt.cartId));
+        writer.append(",");
+    }
+    writer.append("\"time\":");
+    writer.append(static_cast<long long>(receipt.time));
+
+    // Deal groups with their lines
+    writer.append(",\"deal_groups\":[");
+    size_t lineIndex = 0;
+    for (size_t group = 0; group < receipt.dealGroups.size(); group++) {
+        const ReceiptDealGroup& dealGroup = receipt.dealGroups[group];
+        writer.append(group == 0 ? "{\"price_cents\":" : ",{\"price_cents\":");
+        writer.append(static_cast<long long>(dealGroup.price.getCents()));
+        writer.append(",\"savings_cents\":");
+        writer.append(static_cast<long long>(dealGroup.savings.getCents()));
+        writer.append(dealGroup.isBundle ? ",\"bundle\":true,\"lines\":[" : ",\"bundle\":false,\"lines\":[");
+        for (size_t first = lineIndex; lineIndex < receipt.dealLines.size()
+             && receipt.dealLines[lineIndex].dealGroup == static_cast<int>(group); lineIndex++) {
+            if (lineIndex > first) {
+                writer.append(",");
+            }
+            appendJsonLine(writer, receipt.dealLines[lineIndex], true);
+        }
+        writer.append("]}");
+    }
+    writer.append("]");
+
+    // Remaining items
+    writer.append(",\"items\":[");
+    for (size_t i = 0; i < receipt.items.size(); i++) {
+        if (i > 0) {
+            writer.append(",");
+        }
+        appendJsonLine(writer, receipt.items[i], false);
+    }
+    writer.append("],\"savings_cents\":");
+    writer.append(static_cast<long long>(receipt.savings.getCents()));
+    writer.append(",\"total_cents\":");
+    writer.append(static_cast<long long>(receipt.total.getCents()));
+    writer.append("}");
+    writer.endLine();
+    writer.writeTo(out);
+    out.flush();
+}
@@ -1,12 +1,18 @@
 #include "catalog.h"
 #include "checkout_register.h"
+#include "batch_checkout.h"
+#include "store_server.h"
+#include "receipt_sink.h"
 #include "io_helper.h"
+#include "checkout_stats.h"
 
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <iomanip>
+#include <cstdlib>
 
 /**
  * Prints a welcome message to a user.
@@ -70,11 +76,10 @@ void promptUserForInput(const Catalog& catalog, CheckoutRegister& checkoutRegist
         }
         // Remove item
         if (input.find("Remove ") == 0) {
-            std::string itemName = input.substr(7);
-            try {
-                checkoutRegister.removeItem(itemName);
-            } catch (const std::runtime_error& e) {
-                std::cerr << "Error: " << e.what() << std::endl;
+            std::string_view itemName = std::string_view(input).substr(7);
+            ScanStatus status = checkoutRegister.tryRemoveItem(itemName);
+            if (status != ScanStatus::Ok) {
+                std::cerr << "Error: " << CheckoutRegister::scanErrorMessage({itemName, -1, 0}, status) << std::endl;
             }
             continue;
         }
@@ -86,20 +91,24 @@ void promptUserForInput(const Catalog& catalog, CheckoutRegister& checkoutRegist
             std::cout << "Error: Invalid input. Please enter in the format '<item> <quantity>' or use 'remove <item>'." << std::endl;
             continue;
         }
-        std::string itemName = input.substr(0, lastSpacePos);
-        try {
-            // Try parsing quantity and converting to int
-            std::string quantityStr = input.substr(lastSpacePos + 1);
-            int quantity = IOHelper::fullStoi(quantityStr);
-            // Scan item
-            checkoutRegister.scanItem(itemName, quantity);
+        std::string_view itemName = std::string_view(input).substr(0, lastSpacePos);
 
-        } catch (const std::invalid_argument& e) {
+        // Try parsing quantity and converting to int
+        int quantity = 0;
+        IOHelper::ParseStatus parseStatus = IOHelper::parseInt(std::string_view(input).substr(lastSpacePos + 1), quantity);
+        if (parseStatus == IOHelper::ParseStatus::Invalid) {
             std::cerr << "Error: Invalid quantity. Please enter a valid integer larger than 0." << std::endl;
-        }  catch (const std::out_of_range& e) {
-            std::cerr << "Error: Quantity out of range." << std::endl; 
-        } catch (const std::runtime_error& e) {
-            std::cerr << "Error: " << e.what() << std::endl;
+            continue;
+        }
+        if (parseStatus == IOHelper::ParseStatus::OutOfRange) {
+            std::cerr << "Error: Quantity out of range." << std::endl;
+            continue;
+        }
+
+        // Scan item
+        ScanStatus status = checkoutRegister.tryScanItem(itemName, quantity);
+        if (status != ScanStatus::Ok) {
+            std::cerr << "Error: " << CheckoutRegister::scanErrorMessage({itemName, -1, quantity}, status) << std::endl;
         }
     }
 }
@@ -122,28 +131,108 @@ void readFileInput(CheckoutRegister& checkoutRegister, const std::string& filepa
 
     // Iterate over lines in file and scan items
     while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string itemName;
-        std::string quantityStr;
-        std::getline(ss, itemName, ',');
-        std::getline(ss, quantityStr, ',');
+        // Split item name and quantity fields without copying the name
+        std::string_view itemName;
+        std::string_view quantityStr;
+        size_t pos = 0;
+        IOHelper::nextField(line, pos, ',', itemName);
+        IOHelper::nextField(line, pos, ',', quantityStr);
 
-        try {
-            // Try parsing quantity and converting to int
-            int quantity = IOHelper::fullStoi(quantityStr);
-            // Scan item
-            checkoutRegister.scanItem(itemName, quantity);
-
-        } catch (const std::invalid_argument& e) {
-            throw std::runtime_error("Invalid quantity for item: '" + itemName + "' in file: '" + filepath +"'.");
-        } catch (const std::out_of_range& e) {
-            throw std::runtime_error("Invalid quantity for item: '" + itemName + "' in file: '" + filepath +"'.");
-        } catch (const std::runtime_error& e) {
-            throw std::runtime_error("Issue in input file: '" + filepath +"': " + e.what());
+        // Try parsing quantity and converting to int
+        int quantity = 0;
+        if (IOHelper::parseInt(quantityStr, quantity) != IOHelper::ParseStatus::Ok) {
+            throw std::runtime_error("Invalid quantity for item: '" + std::string(itemName) + "' in file: '" + filepath +"'.");
+        }
+
+        // Scan item
+        ScanStatus status = checkoutRegister.tryScanItem(itemName, quantity);
+        if (status != ScanStatus::Ok) {
+            throw std::runtime_error("Issue in input file: '" + filepath +"': "
+                                     + CheckoutRegister::scanErrorMessage({itemName, -1, quantity}, status));
         }
     }    
 }
 
+/**
+ * Prints the size, time taken, and throughput of reading each catalog file to the standard error.
+ * @param catalog The Supermarket catalog.
+*/
+void printLoadStats(const Catalog& catalog) {
+    for (const Catalog::LoadStats& stats : catalog.getLoadStats()) {
+        double megabytesPerSecond = stats.seconds > 0 ? stats.bytes / stats.seconds / 1e6 : 0;
+        std::cerr << "Loaded '" << stats.filepath << "': " << stats.bytes << " bytes in "
+                  << std::fixed << std::setprecision(3) << stats.seconds * 1e3 << " ms ("
+                  << std::setprecision(1) << megabytesPerSecond << " MB/s)" << std::endl;
+    }
+}
+
+/**
+ * Reads the catalog from the snapshot file or from the items and deals files.
+ * @param isSnapshotInput Whether to read the snapshot file.
+ * @returns The catalog.
+*/
+std::shared_ptr<Catalog> loadCatalog(bool isSnapshotInput) {
+    auto catalog = std::make_shared<Catalog>();
+    if (isSnapshotInput) {
+        catalog->loadSnapshot("data/catalog.snapshot");
+    } else {
+        catalog->readItemsFromFile("data/items.csv");
+        catalog->readDealsFromFile("data/deals.csv");
+    }
+    return catalog;
+}
+
+/**
+ * Prints the latency and allocations of each checkout phase to the standard error.
+ * Registered to run at exit so that every phase of the run is included.
+*/
+void printCheckoutStats() {
+    CheckoutStats::print(std::cerr);
+}
+
+/**
+ * Checks out all carts in the batch input file and prints their receipts ordered by cart id.
+ * @param catalog The Supermarket catalog.
+ * @param isFileOutput Whether to print the receipts to the receipts file rather than the console.
+ * @param format The format of the receipts.
+ * @returns The program exit code.
+*/
+int runBatch(const Catalog& catalog, bool isFileOutput, ReceiptFormat format) {
+    // Read carts
+    BatchCheckout batch(catalog, 0, format);
+    try {
+        batch.readCartsFromFile("input/carts.csv");
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Check out carts across all cores
+    batch.checkOut();
+
+    // Print receipts
+    int failedCarts;
+    if (isFileOutput) {
+        // Create output directory if it does not exist
+        std::filesystem::create_directory("output");
+
+        // Clear or create receipts file, opened once for all receipts
+        std::string filepath = std::string("output/receipts.") + ReceiptSink::fileExtension(format);
+        std::ofstream file(filepath, std::ios::binary);
+
+        // Check if file was successfully open
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not create or open file: '" << filepath << "'." << std::endl;
+            return 1;
+        }
+
+        failedCarts = batch.printReceipts(file);
+    } else {
+        failedCarts = batch.printReceipts();
+    }
+    return failedCarts == 0 ? 0 : 1;
+}
+
 /**
  * Entry point to program.
 */
@@ -152,6 +241,15 @@ int main(int argc, char* argv[]) {
     // Parse command line arguments
     bool isFileInput = false;
     bool isFileOutput = false;
+    bool isBatch = false;
+    bool isStats = false;
+    bool isSnapshotInput = false;
+    bool isSnapshotOutput = false;
+    int laneCount = 0;
+    std::string socketPath;
+    std::string journalPath;
+    ReceiptFormat format = ReceiptFormat::Text;
+    bool isFormatSet = false;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         // Check for input flag
@@ -160,24 +258,132 @@ int main(int argc, char* argv[]) {
         // Check for output flag
         } else if (arg == "-o") {
             isFileOutput = true;
+        // Check for batch flag
+        } else if (arg == "-b") {
+            isBatch = true;
+        // Check for stats flag
+        } else if (arg == "--stats") {
+            isStats = true;
+        // Check for snapshot flags
+        } else if (arg == "--snapshot") {
+            isSnapshotInput = true;
+        } else if (arg == "--save-snapshot") {
+            isSnapshotOutput = true;
+        // Check for store flags
+        } else if (arg == "--lanes" && i + 1 < argc) {
+            if (IOHelper::parseInt(argv[++i], laneCount) != IOHelper::ParseStatus::Ok) {
+                laneCount = 0;
+            }
+            if (laneCount < 1) {
+                std::cerr << "Error: " << "Argument --lanes must be followed by a number of lanes larger than 0." << std::endl;
+                return 1;
+            }
+        } else if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        // Check for journal flag
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journalPath = argv[++i];
+        // Check for receipt format
+        } else if (arg == "--format" && i + 1 < argc) {
+            if (!ReceiptSink::parseFormat(argv[++i], format)) {
+                std::cerr << "Error: " << "Unknown receipt format: " << argv[i] << ". Use text, jsonl or binary." << std::endl;
+                return 1;
+            }
+            isFormatSet = true;
         } else {
             std::cerr << "Error: " << "Unknown argument passed: " << arg << std::endl;
             return 1;
         }
     }
+    if (isBatch && isFileInput) {
+        std::cerr << "Error: " << "Arguments -i and -b may not be used together." << std::endl;
+        return 1;
+    }
+    bool isStore = laneCount > 0 || !socketPath.empty();
+    if (isStore && (isBatch || isFileInput || isFileOutput)) {
+        std::cerr << "Error: " << "Arguments --lanes and --socket may not be used with -i, -o or -b." << std::endl;
+        return 1;
+    }
+    if (isStore && isFormatSet) {
+        std::cerr << "Error: " << "Arguments --lanes and --socket may not be used with --format." << std::endl;
+        return 1;
+    }
+    if (format == ReceiptFormat::Binary && !isFileOutput) {
+        std::cerr << "Error: " << "Binary receipts may only be written to a file with -o." << std::endl;
+        return 1;
+    }
+    if (laneCount > 0 && !socketPath.empty()) {
+        std::cerr << "Error: " << "Arguments --lanes and --socket may not be used together." << std::endl;
+        return 1;
+    }
+    if (!journalPath.empty() && (isBatch || !socketPath.empty())) {
+        std::cerr << "Error: " << "Argument --journal may not be used with -b or --socket." << std::endl;
+        return 1;
+    }
+    if (isSnapshotInput && isSnapshotOutput) {
+        std::cerr << "Error: " << "Arguments --snapshot and --save-snapshot may not be used together." << std::endl;
+        return 1;
+    }
+
+    // Dump checkout phase statistics when the program exits
+    if (isStats) {
+        std::atexit(printCheckoutStats);
+    }
 
     // Initialize catalog, read items, and read deals
-    Catalog catalog;
+    std::shared_ptr<Catalog> catalog;
     try {
-        catalog.readItemsFromFile("data/items.csv");
-        catalog.readDealsFromFile("data/deals.csv");
+        catalog = loadCatalog(isSnapshotInput);
+        if (isSnapshotOutput) {
+            catalog->saveSnapshot("data/catalog.snapshot");
+        }
     } catch (const std::runtime_error& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
+    if (isStats) {
+        printLoadStats(*catalog);
+    }
+
+    // Check out all carts of the batch file
+    if (isBatch) {
+        return runBatch(*catalog, isFileOutput, format);
+    }
+
+    // Run many lanes at once, multiplexed over the standard input or served over a socket.
+    // The reload command rereads the same catalog files while the lanes keep running
+    if (isStore) {
+        CatalogManager catalogManager(catalog, [isSnapshotInput]() {
+            return loadCatalog(isSnapshotInput);
+        });
+        try {
+            if (laneCount > 0) {
+                StoreServer store(catalogManager, laneCount);
+                if (!journalPath.empty()) {
+                    store.openJournal(journalPath);
+                }
+                store.run(std::cin);
+            } else {
+                StoreServer::serveUnixSocket(catalogManager, socketPath);
+            }
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    // Initialize checkout register
-    CheckoutRegister checkoutRegister(catalog);
+    // Initialize checkout register, recovering its open cart from the journal
+    CheckoutRegister checkoutRegister(*catalog);
+    std::unique_ptr<Journal> journal;
+    if (!journalPath.empty()) {
+        try {
+            journal = CheckoutRegister::recoverJournal(journalPath, {&checkoutRegister});
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
 
     // Scan items
     if (isFileInput) {
@@ -190,7 +396,7 @@ int main(int argc, char* argv[]) {
         }
     } else {
         // Prompt user to scan items manually
-        promptUserForInput(catalog, checkoutRegister);
+        promptUserForInput(*catalog, checkoutRegister);
     }
 
     // Checkout
@@ -199,18 +405,19 @@ int main(int argc, char* argv[]) {
         std::filesystem::create_directory("output");
 
         // Clear or create receipt file
-        std::ofstream file("output/receipt.txt");
+        std::string filepath = std::string("output/receipt.") + ReceiptSink::fileExtension(format);
+        std::ofstream file(filepath, std::ios::binary);
 
         // Check if file was successfully open
         if (!file.is_open()) {
-            std::cerr << "Error: Could not create or open file: 'output/receipt.txt'." << std::endl;
+            std::cerr << "Error: Could not create or open file: '" << filepath << "'." << std::endl;
             return 1;
         }
 
         // Print receipt to file
-        checkoutRegister.checkOut(file);
+        checkoutRegister.checkOut(*ReceiptSink::create(format, file));
     } else {
        // Print receipt to console
-        checkoutRegister.checkOut();
+        checkoutRegister.checkOut(*ReceiptSink::create(format, std::cout));
     }
 }
\ No newline at end of file
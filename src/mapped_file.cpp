@@ -0,0 +1,84 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filepath) : data(nullptr), size(0), open(false) {
+    // Read the whole file into the buffer instead of mapping it
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        return;
+    }
+    std::ostringstream contentsStream;
+    contentsStream << file.rdbuf();
+    buffer = contentsStream.str();
+    data = buffer.data();
+    size = buffer.size();
+    open = true;
+}
+
+MappedFile::~MappedFile() {}
+
+#else
+
+MappedFile::MappedFile(const std::string& filepath) : data(nullptr), size(0), open(false) {
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return;
+    }
+
+    // Map regular files, unless they are empty (which mmap does not allow)
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0) {
+        void* mapping = ::mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            // Files are scanned front to back
+            ::madvise(mapping, fileStat.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(mapping);
+            size = fileStat.st_size;
+            open = true;
+        }
+    }
+
+    // Read anything that cannot be mapped, such as pipes, into the buffer instead
+    if (!open) {
+        char chunk[65536];
+        ssize_t bytesRead;
+        while ((bytesRead = ::read(fd, chunk, sizeof(chunk))) > 0) {
+            buffer.append(chunk, bytesRead);
+        }
+        if (bytesRead == 0) {
+            data = buffer.data();
+            size = buffer.size();
+            open = true;
+        }
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr && data != buffer.data()) {
+        ::munmap(const_cast<char*>(data), size);
+    }
+}
+
+#endif
+
+bool MappedFile::isOpen() const {
+    return open;
+}
+
+std::string_view MappedFile::contents() const {
+    return std::string_view(data, size);
+}
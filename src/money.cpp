@@ -0,0 +1,100 @@
+#include "money.h"
+
+#include <cctype>
+
+bool Money::parse(std::string_view str, Money& amount) {
+    size_t i = 0;
+    size_t length = str.size();
+
+    // Skip leading whitespace
+    while (i < length && std::isspace(static_cast<unsigned char>(str[i]))) {
+        i++;
+    }
+
+    // Read sign
+    bool negative = false;
+    if (i < length && (str[i] == '+' || str[i] == '-')) {
+        negative = str[i] == '-';
+        i++;
+    }
+
+    // Read whole dollars, limiting digits so the amount in cents cannot overflow
+    std::int64_t dollars = 0;
+    int digits = 0;
+    while (i < length && std::isdigit(static_cast<unsigned char>(str[i]))) {
+        if (++digits > 15) {
+            return false;
+        }
+        dollars = dollars * 10 + (str[i++] - '0');
+    }
+
+    // Read cents, rounding on the first dropped digit
+    std::int64_t fraction = 0;
+    if (i < length && str[i] == '.') {
+        i++;
+        int fractionDigits = 0;
+        while (i < length && std::isdigit(static_cast<unsigned char>(str[i]))) {
+            if (fractionDigits < 2) {
+                fraction = fraction * 10 + (str[i] - '0');
+            } else if (fractionDigits == 2 && str[i] >= '5') {
+                fraction++;
+            }
+            fractionDigits++;
+            digits++;
+            i++;
+        }
+        // Scale single digit fractions such as ".5" to cents
+        if (fractionDigits == 1) {
+            fraction *= 10;
+        }
+    }
+
+    // Require at least one digit
+    if (digits == 0) {
+        return false;
+    }
+
+    // Skip trailing whitespace and check that the full string was parsed
+    while (i < length && std::isspace(static_cast<unsigned char>(str[i]))) {
+        i++;
+    }
+    if (i != length) {
+        return false;
+    }
+
+    std::int64_t cents = dollars * 100 + fraction;
+    amount = Money(negative ? -cents : cents);
+    return true;
+}
+
+int Money::format(char* buffer) const {
+    // Write digits backwards into a scratch buffer, always including at least one dollar digit
+    char digits[maxFormattedLength];
+    int count = 0;
+    std::uint64_t value = cents < 0 ? -static_cast<std::uint64_t>(cents) : cents;
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+    digits[count++] = '.';
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    // Write dollar sign and sign, matching how streams print negative amounts ("$-1.50")
+    int length = 0;
+    buffer[length++] = '$';
+    if (cents < 0) {
+        buffer[length++] = '-';
+    }
+    while (count > 0) {
+        buffer[length++] = digits[--count];
+    }
+    return length;
+}
+
+std::string Money::toString() const {
+    char buffer[maxFormattedLength];
+    return std::string(buffer, format(buffer));
+}
@@ -0,0 +1,66 @@
+#include "pricing_kernel.h"
+#include "cpu_features.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PRICING_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+std::int64_t PricingKernel::priceLinesScalar(const std::int64_t* unitPrices, const int* quantities, size_t count,
+                                             std::int64_t* linePrices) {
+    // Multiply and add as unsigned integers, which wrap around exactly like the AVX2 kernel
+    std::uint64_t total = 0;
+    for (size_t line = 0; line < count; ++line) {
+        std::uint64_t price = static_cast<std::uint64_t>(unitPrices[line]) * static_cast<std::uint32_t>(quantities[line]);
+        linePrices[line] = static_cast<std::int64_t>(price);
+        total += price;
+    }
+    return static_cast<std::int64_t>(total);
+}
+
+#ifdef PRICING_KERNEL_AVX2
+__attribute__((target("avx2")))
+std::int64_t PricingKernel::priceLinesAvx2(const std::int64_t* unitPrices, const int* quantities, size_t count,
+                                           std::int64_t* linePrices) {
+    __m256i totals = _mm256_setzero_si256();
+    size_t line = 0;
+    for (; line + 4 <= count; line += 4) {
+        // Load the unit prices of the next four lines, and widen their quantities to 64 bits
+        __m256i price = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(unitPrices + line));
+        __m256i quantity = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(quantities + line)));
+
+        // AVX2 only multiplies 32 bit halves, so multiply the low and high halves of each price
+        // separately and add the high product shifted into place, giving the low 64 bits of the product
+        __m256i low = _mm256_mul_epu32(price, quantity);
+        __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(price, 32), quantity);
+        __m256i linePrice = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(linePrices + line), linePrice);
+        totals = _mm256_add_epi64(totals, linePrice);
+    }
+
+    // Add the four partial totals, and price the remaining lines one at a time
+    alignas(32) std::uint64_t partials[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(partials), totals);
+    std::uint64_t total = partials[0] + partials[1] + partials[2] + partials[3];
+    total += static_cast<std::uint64_t>(priceLinesScalar(unitPrices + line, quantities + line, count - line, linePrices + line));
+    return static_cast<std::int64_t>(total);
+}
+#else
+std::int64_t PricingKernel::priceLinesAvx2(const std::int64_t* unitPrices, const int* quantities, size_t count,
+                                           std::int64_t* linePrices) {
+    return priceLinesScalar(unitPrices, quantities, count, linePrices);
+}
+#endif
+
+std::int64_t PricingKernel::priceLines(const std::int64_t* unitPrices, const int* quantities, size_t count,
+                                       std::int64_t* linePrices) {
+    // Unoptimized builds keep the intrinsics' vectors on the stack, which makes the AVX2 kernel slower
+    // than the scalar loop, so only optimized builds dispatch to it
+#ifdef __OPTIMIZE__
+    if (CpuFeatures::hasAvx2()) {
+        return priceLinesAvx2(unitPrices, quantities, count, linePrices);
+    }
+#endif
+    return priceLinesScalar(unitPrices, quantities, count, linePrices);
+}
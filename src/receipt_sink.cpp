@@ -0,0 +1,39 @@
+#include "receipt_sink.h"
+#include "text_receipt_sink.h"
+#include "json_receipt_sink.h"
+#include "binary_receipt_sink.h"
+
+std::unique_ptr<ReceiptSink> ReceiptSink::create(ReceiptFormat format, std::ostream& out) {
+    switch (format) {
+        case ReceiptFormat::JsonLines:
+            return std::unique_ptr<ReceiptSink>(new JsonReceiptSink(out));
+        case ReceiptFormat::Binary:
+            return std::unique_ptr<ReceiptSink>(new BinaryReceiptSink(out));
+        default:
+            return std::unique_ptr<ReceiptSink>(new TextReceiptSink(out));
+    }
+}
+
+bool ReceiptSink::parseFormat(std::string_view name, ReceiptFormat& format) {
+    if (name == "text") {
+        format = ReceiptFormat::Text;
+    } else if (name == "jsonl") {
+        format = ReceiptFormat::JsonLines;
+    } else if (name == "binary") {
+        format = ReceiptFormat::Binary;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* ReceiptSink::fileExtension(ReceiptFormat format) {
+    switch (format) {
+        case ReceiptFormat::JsonLines:
+            return "jsonl";
+        case ReceiptFormat::Binary:
+            return "bin";
+        default:
+            return "txt";
+    }
+}
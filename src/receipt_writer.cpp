@@ -0,0 +1,138 @@
+#include "receipt_writer.h"
+
+#include <charconv>
+
+namespace {
+    /**
+     * Longest precomputed separator line. Longer lines are appended in pieces.
+    */
+    const size_t separatorLength = 128;
+
+    /**
+     * A precomputed solid line of separatorLength characters.
+    */
+    const std::string solidSeparator(separatorLength, '-');
+
+    /**
+     * A precomputed dashed line of separatorLength characters.
+    */
+    const std::string dashedSeparator = []() {
+        std::string dashes;
+        for (size_t i = 0; i < separatorLength / 2; i++) {
+            dashes += "- ";
+        }
+        return dashes;
+    }();
+
+    /**
+     * Appends a prefix of a precomputed separator, repeating it for lengths longer than the separator.
+     * @param buffer The buffer.
+     * @param separator The separator.
+     * @param length The number of characters to append.
+    */
+    void appendSeparator(std::string& buffer, const std::string& separator, size_t length) {
+        while (length > separator.size()) {
+            buffer.append(separator);
+            length -= separator.size();
+        }
+        buffer.append(separator, 0, length);
+    }
+}
+
+ReceiptWriter::ReceiptWriter(size_t capacity) {
+    buffer.reserve(capacity);
+}
+
+void ReceiptWriter::clear() {
+    buffer.clear();
+}
+
+std::string_view ReceiptWriter::text() const {
+    return buffer;
+}
+
+void ReceiptWriter::writeTo(std::ostream& out) {
+    out.write(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+void ReceiptWriter::append(std::string_view str) {
+    buffer.append(str);
+}
+
+void ReceiptWriter::append(long long value) {
+    char digits[24];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer.append(digits, end - digits);
+}
+
+void ReceiptWriter::append(Money amount) {
+    char formatted[Money::maxFormattedLength];
+    buffer.append(formatted, amount.format(formatted));
+}
+
+void ReceiptWriter::endLine() {
+    buffer.push_back('\n');
+}
+
+size_t ReceiptWriter::mark() const {
+    return buffer.size();
+}
+
+void ReceiptWriter::padFrom(size_t fieldStart, int width) {
+    size_t length = buffer.size() - fieldStart;
+    if (length < static_cast<size_t>(width)) {
+        buffer.append(width - length, ' ');
+    }
+}
+
+void ReceiptWriter::appendLeft(std::string_view str, int width) {
+    size_t fieldStart = mark();
+    buffer.append(str);
+    padFrom(fieldStart, width);
+}
+
+void ReceiptWriter::appendRight(std::string_view str, int width) {
+    if (str.size() < static_cast<size_t>(width)) {
+        buffer.append(width - str.size(), ' ');
+    }
+    buffer.append(str);
+}
+
+void ReceiptWriter::appendRight(long long value, int width) {
+    char digits[24];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    appendRight(std::string_view(digits, end - digits), width);
+}
+
+void ReceiptWriter::appendRight(Money amount, int width) {
+    char formatted[Money::maxFormattedLength];
+    appendRight(std::string_view(formatted, amount.format(formatted)), width);
+}
+
+void ReceiptWriter::centeredLine(std::string_view str, int totalWidth) {
+    // Text at least as wide as the line is printed twice, as IOHelper::printCentered does
+    int length = str.size();
+    if (length >= totalWidth) {
+        buffer.append(str);
+        endLine();
+    }
+
+    // Pad on the left only
+    int padding = (totalWidth - length) / 2;
+    if (padding > 0) {
+        buffer.append(padding, ' ');
+    }
+    buffer.append(str);
+    endLine();
+}
+
+void ReceiptWriter::solidLine(int length) {
+    appendSeparator(buffer, solidSeparator, length);
+    endLine();
+}
+
+void ReceiptWriter::dashedLine(int length) {
+    appendSeparator(buffer, dashedSeparator, length / 2 * 2);
+    endLine();
+}
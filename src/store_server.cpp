@@ -0,0 +1,323 @@
+#include "store_server.h"
+#include "io_helper.h"
+
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace {
+    /**
+     * The number of commands each worker queue can hold before the submitting thread waits.
+    */
+    const size_t queueCapacity = 4096;
+
+    /**
+     * The number of times an idle worker polls its queue before it starts sleeping between polls.
+    */
+    const int idlePolls = 1000;
+
+    /**
+     * The time an idle worker sleeps between polls of its queue.
+    */
+    const std::chrono::microseconds idleSleep(100);
+
+#ifndef _WIN32
+    /**
+     * Flags for sending responses, so a client that disconnects early does not kill the process.
+    */
+#ifdef MSG_NOSIGNAL
+    const int sendFlags = MSG_NOSIGNAL;
+#else
+    const int sendFlags = 0;
+#endif
+#endif
+}
+
+StoreServer::StoreServer(CatalogManager& catalogManager, int laneCount, std::ostream& out, unsigned int threadCount,
+                         bool isTrackingLatency) : catalogManager(catalogManager), laneCount(laneCount), out(out), isTrackingLatency(isTrackingLatency),
+                         isStopping(false) {
+    if (laneCount < 1) {
+        throw std::runtime_error("A store must have at least one lane.");
+    }
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::min<unsigned int>(threadCount, laneCount);
+
+    // Give each worker the registers of every lane with the worker's index modulo the worker count
+    for (unsigned int i = 0; i < threadCount; i++) {
+        workers.emplace_back(new Worker(queueCapacity));
+    }
+    for (int lane = 0; lane < laneCount; lane++) {
+        workers[lane % threadCount]->registers.emplace_back(new CheckoutRegister(catalogManager));
+    }
+
+    // Start workers once all of them exist
+    for (std::unique_ptr<Worker>& worker : workers) {
+        worker->thread = std::thread(&StoreServer::runWorker, this, std::ref(*worker));
+    }
+}
+
+StoreServer::~StoreServer() {
+    stop();
+}
+
+void StoreServer::openJournal(const std::string& filepath) {
+    // The workers only touch their registers to run commands, so none are in use yet
+    std::vector<CheckoutRegister*> registers;
+    for (int lane = 0; lane < laneCount; lane++) {
+        registers.push_back(workers[lane % workers.size()]->registers[lane / workers.size()].get());
+    }
+    journal = CheckoutRegister::recoverJournal(filepath, registers);
+}
+
+int StoreServer::getLaneCount() const {
+    return laneCount;
+}
+
+void StoreServer::submit(int lane, std::string command) {
+    if (lane < 0 || lane >= laneCount) {
+        throw std::runtime_error("Lane " + std::to_string(lane) + " does not exist.");
+    }
+
+    // Wait for room in the worker's queue
+    Worker& worker = *workers[lane % workers.size()];
+    Command queued = {lane, std::move(command), std::chrono::steady_clock::now()};
+    while (!worker.queue.tryPush(queued)) {
+        std::this_thread::yield();
+    }
+    worker.submitted++;
+}
+
+void StoreServer::drain() {
+    for (std::unique_ptr<Worker>& worker : workers) {
+        while (worker->processed.load(std::memory_order_acquire) < worker->submitted) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void StoreServer::stop() {
+    if (isStopping.exchange(true)) {
+        return;
+    }
+    for (std::unique_ptr<Worker>& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void StoreServer::run(std::istream& in) {
+    std::string line;
+    while (std::getline(in, line)) {
+        // Split the lane number from the command
+        size_t laneEnd = line.find(' ');
+        int lane = -1;
+        if (IOHelper::parseInt(std::string_view(line).substr(0, laneEnd), lane) != IOHelper::ParseStatus::Ok) {
+            lane = -1;
+        }
+        if (laneEnd == std::string::npos || lane < 0 || lane >= laneCount) {
+            writeResponse(-1, "Error: Invalid input. Please enter in the format '<lane> <command>' with a lane from 0 to "
+                          + std::to_string(laneCount - 1) + ".\n");
+            continue;
+        }
+        submit(lane, line.substr(laneEnd + 1));
+    }
+    drain();
+}
+
+std::vector<std::uint64_t> StoreServer::getLatencies() const {
+    std::vector<std::uint64_t> latencies;
+    for (const std::unique_ptr<Worker>& worker : workers) {
+        latencies.insert(latencies.end(), worker->latencies.begin(), worker->latencies.end());
+    }
+    return latencies;
+}
+
+void StoreServer::runWorker(Worker& worker) {
+    Command command;
+    int idle = 0;
+    while (true) {
+        if (!worker.queue.tryPop(command)) {
+            // Stop once the queue is empty after stopping was requested
+            if (isStopping.load(std::memory_order_acquire)) {
+                if (!worker.queue.tryPop(command)) {
+                    return;
+                }
+            } else {
+                // Back off from polling an idle queue
+                if (++idle < idlePolls) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(idleSleep);
+                }
+                continue;
+            }
+        }
+        idle = 0;
+
+        // Run the command on the lane's register
+        CheckoutRegister& checkoutRegister = *worker.registers[command.lane / workers.size()];
+        std::string response = handleCommand(catalogManager, checkoutRegister, std::move(command.text));
+        if (!response.empty()) {
+            writeResponse(command.lane, response);
+        }
+
+        if (isTrackingLatency) {
+            auto elapsed = std::chrono::steady_clock::now() - command.submitted;
+            worker.latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+        worker.processed.store(worker.processed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
+
+void StoreServer::writeResponse(int lane, const std::string& response) {
+    std::lock_guard<std::mutex> lock(outMutex);
+    if (lane >= 0) {
+        out << "Lane " << lane << "\n";
+    }
+    out << response << std::flush;
+}
+
+std::string StoreServer::handleCommand(CatalogManager& catalogManager, CheckoutRegister& checkoutRegister, std::string command) {
+    // Set case, matching interactive input
+    IOHelper::toCamelCase(command);
+
+    // Print receipt and clear the cart
+    if (command == "Checkout") {
+        std::ostringstream receipt;
+        checkoutRegister.checkOut(receipt);
+        return receipt.str();
+    }
+    // Abandon the cart
+    if (command == "Cancel") {
+        checkoutRegister.clearSession();
+        return "Cart cleared.\n";
+    }
+    // Build and publish a new catalog version, picked up by each lane at the start of its next cart
+    if (command == "Reload") {
+        try {
+            if (!catalogManager.reloadInBackground()) {
+                return "Error: A catalog reload is already in progress.\n";
+            }
+        } catch (const std::runtime_error& e) {
+            return "Error: " + std::string(e.what()) + "\n";
+        }
+        return "Reloading catalog.\n";
+    }
+    // Show cart, items or deals
+    if (command == "Cart" || command == "Items" || command == "Deals") {
+        std::ostringstream listing;
+        if (command == "Cart") {
+            checkoutRegister.printCart(listing);
+        } else if (command == "Items") {
+            checkoutRegister.getCatalog().printItems(listing);
+        } else {
+            checkoutRegister.getCatalog().printDeals(listing);
+        }
+        return listing.str();
+    }
+    // Remove item
+    if (command.find("Remove ") == 0) {
+        std::string_view itemName = std::string_view(command).substr(7);
+        ScanStatus status = checkoutRegister.tryRemoveItem(itemName);
+        if (status != ScanStatus::Ok) {
+            return "Error: " + CheckoutRegister::scanErrorMessage({itemName, -1, 0}, status) + "\n";
+        }
+        return "";
+    }
+
+    // Scan item and quantity, separated by the last space
+    size_t lastSpacePos = command.find_last_of(' ');
+    if (lastSpacePos == std::string::npos) {
+        return "Error: Invalid input. Please enter in the format '<item> <quantity>' or use 'remove <item>'.\n";
+    }
+    int quantity = 0;
+    IOHelper::ParseStatus parseStatus = IOHelper::parseInt(std::string_view(command).substr(lastSpacePos + 1), quantity);
+    if (parseStatus == IOHelper::ParseStatus::Invalid) {
+        return "Error: Invalid quantity. Please enter a valid integer larger than 0.\n";
+    }
+    if (parseStatus == IOHelper::ParseStatus::OutOfRange) {
+        return "Error: Quantity out of range.\n";
+    }
+    std::string_view itemName = std::string_view(command).substr(0, lastSpacePos);
+    ScanStatus status = checkoutRegister.tryScanItem(itemName, quantity);
+    if (status != ScanStatus::Ok) {
+        return "Error: " + CheckoutRegister::scanErrorMessage({itemName, -1, quantity}, status) + "\n";
+    }
+    return "";
+}
+
+#ifndef _WIN32
+void StoreServer::serveUnixSocket(CatalogManager& catalogManager, const std::string& socketPath) {
+    // Create socket, replacing any stale socket file from a previous run
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path '" + socketPath + "' is too long.");
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server == -1) {
+        throw std::runtime_error("Cannot create socket: '" + socketPath + "'.");
+    }
+    unlink(socketPath.c_str());
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 || listen(server, SOMAXCONN) == -1) {
+        close(server);
+        throw std::runtime_error("Cannot listen on socket: '" + socketPath + "'.");
+    }
+
+    // Serve each connection as a lane on its own thread with its own register
+    while (true) {
+        int connection = accept(server, nullptr, nullptr);
+        if (connection == -1) {
+            continue;
+        }
+        std::thread([&catalogManager, connection]() {
+            CheckoutRegister checkoutRegister(catalogManager);
+            std::string pending;
+            char buffer[4096];
+            ssize_t bytesRead;
+            while ((bytesRead = read(connection, buffer, sizeof(buffer))) > 0) {
+                pending.append(buffer, bytesRead);
+
+                // Run every complete line
+                size_t lineStart = 0;
+                size_t lineEnd;
+                while ((lineEnd = pending.find('\n', lineStart)) != std::string::npos) {
+                    std::string command = pending.substr(lineStart, lineEnd - lineStart);
+                    if (!command.empty() && command.back() == '\r') {
+                        command.pop_back();
+                    }
+                    lineStart = lineEnd + 1;
+
+                    // Acknowledge successful scans and removals so clients can wait for every command
+                    std::string response = handleCommand(catalogManager, checkoutRegister, std::move(command));
+                    if (response.empty()) {
+                        response = "OK\n";
+                    }
+                    for (size_t written = 0; written < response.size(); ) {
+                        ssize_t count = send(connection, response.data() + written, response.size() - written, sendFlags);
+                        if (count <= 0) {
+                            break;
+                        }
+                        written += count;
+                    }
+                }
+                pending.erase(0, lineStart);
+            }
+            close(connection);
+        }).detach();
+    }
+}
+#else
+void StoreServer::serveUnixSocket(CatalogManager& catalogManager, const std::string& socketPath) {
+    throw std::runtime_error("Unix sockets are not supported on this platform.");
+}
+#endif
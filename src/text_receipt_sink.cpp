@@ -0,0 +1,136 @@
+#include "text_receipt_sink.h"
+
+namespace {
+    /**
+     * Width of the item column of receipts.
+    */
+    const int receiptItemWidth = 30;
+
+    /**
+     * Width of the price column of receipts.
+    */
+    const int receiptPriceWidth = 10;
+}
+
+TextReceiptSink::TextReceiptSink(std::ostream& out) : out(out) {}
+
+void TextReceiptSink::write(const Receipt& receipt) {
+    format(receipt, writer);
+    writer.writeTo(out);
+    out.flush();
+}
+
+void TextReceiptSink::format(const Receipt& receipt, ReceiptWriter& writer) {
+    // Column widths
+    const int itemWidth = receiptItemWidth;
+    const int priceWidth = receiptPriceWidth;
+    const int totalWidth = itemWidth + priceWidth;
+    
+    // Receipt header section
+    writer.solidLine(totalWidth);
+    writer.centeredLine("Supermarket", totalWidth);
+    writer.centeredLine("Customer Receipt", totalWidth);
+
+    // Format date and time, using the reentrant localtime variant since registers may run concurrently
+    std::tm localTime;
+#ifdef _WIN32
+    localtime_s(&localTime, &receipt.time);
+#else
+    localtime_r(&receipt.time, &localTime);
+#endif
+    char dateTime[32];
+    size_t dateTimeLength = std::strftime(dateTime, sizeof(dateTime), "%Y-%m-%d %H:%M", &localTime);
+
+    // Print date and time
+    writer.centeredLine(std::string_view(dateTime, dateTimeLength), totalWidth);
+    writer.solidLine(totalWidth);
+
+    if (!receipt.dealLines.empty()) {
+        // Deals section
+        // Deal header
+        writer.centeredLine("Deals", totalWidth);
+        writer.solidLine(totalWidth);
+        writer.appendLeft("Item", itemWidth);
+        writer.appendRight("Price", priceWidth);
+        writer.endLine();
+        writer.dashedLine(totalWidth);
+
+        // Print each line of the deal groups, with a dashed line after the line ending each group
+        for (size_t i = 0; i < receipt.dealLines.size(); ++i) {
+            const ReceiptLine& line = receipt.dealLines[i];
+            // Print name and quantity
+            size_t nameStart = writer.mark();
+            writer.append(line.name);
+            writer.append(" (");
+            writer.append(static_cast<long long>(line.quantity));
+            writer.append(")");
+            writer.padFrom(nameStart, itemWidth);
+
+            // Print price, checking if free
+            if (line.isFree) {
+                writer.appendRight("FREE", priceWidth);
+            } else {
+                writer.appendRight(line.price, priceWidth);
+            }
+            writer.endLine();
+            if (i + 1 < receipt.dealLines.size() && receipt.dealLines[i + 1].dealGroup == line.dealGroup) {
+                continue;
+            }
+
+            // Bundle lines show regular prices, so follow them with the price of the bundle
+            const ReceiptDealGroup& group = receipt.dealGroups[line.dealGroup];
+            if (group.isBundle) {
+                writer.appendLeft("Bundle Price", itemWidth);
+                writer.appendRight(group.price, priceWidth);
+                writer.endLine();
+            }
+            writer.dashedLine(totalWidth);
+        }
+        
+        // Print savings
+        writer.append("You saved ");
+        writer.append(receipt.savings);
+        writer.append("!");
+        writer.endLine();
+        writer.solidLine(totalWidth);
+
+        // Print items header
+        writer.centeredLine("Remaining Items", totalWidth);
+        writer.solidLine(totalWidth);
+    } else {
+        // Print items header
+        writer.centeredLine("Items", totalWidth);
+        writer.solidLine(totalWidth);
+    }
+
+    // Items section
+    writer.appendLeft("Item", itemWidth);
+    writer.appendRight("Price", priceWidth);
+    writer.endLine();
+    writer.dashedLine(totalWidth);
+
+    // Iterate over remaining items
+    for (const ReceiptLine& line : receipt.items) {
+        // Print name
+        size_t nameStart = writer.mark();
+        writer.append(line.name);
+        writer.append(" (");
+        writer.append(static_cast<long long>(line.quantity));
+        writer.append(") ");
+        writer.padFrom(nameStart, itemWidth);
+
+        // Print price
+        writer.appendRight(line.price, priceWidth);
+        writer.endLine();
+    }
+    writer.solidLine(totalWidth);
+
+    // Total section
+    writer.appendLeft("Grand Total:", itemWidth);
+    writer.appendRight(receipt.total, priceWidth);
+    writer.endLine();
+
+    writer.solidLine(totalWidth);
+    writer.centeredLine("Thank you for shopping with us!", totalWidth);
+    writer.solidLine(totalWidth);
+}
@@ -0,0 +1,414 @@
+#include "money.h"
+#include "deal.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <filesystem>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Parameters of the generated catalog and cart stream.
+*/
+struct TrafficConfig {
+    std::string outDir = "traffic";
+    int itemCount = 10000;
+    int dealCount = 1000;
+    int minDealSize = 2;
+    int maxDealSize = 5;
+    double dealOverlap = 0.1;
+    std::vector<double> dealTypes = {6, 2, 2};
+    std::string prices = "lognormal";
+    Money minPrice = Money(25);
+    Money maxPrice = Money(5000);
+    Money medianPrice = Money(350);
+    int cartCount = 10000;
+    int meanLines = 20;
+    int maxQuantity = 6;
+    double zipf = 1.0;
+    double unknownScans = 0;
+    int lanes = 8;
+    unsigned long long seed = 1;
+};
+
+/**
+ * The size of what was generated.
+*/
+struct TrafficSummary {
+    long long items = 0;
+    long long deals = 0;
+    long long carts = 0;
+    long long lines = 0;
+    long long unknownLines = 0;
+};
+
+/**
+ * Prints the command line usage of the generator to the standard error.
+*/
+void printUsage() {
+    std::cerr << "Usage: supermarket_generate_traffic [options]" << std::endl;
+    std::cerr << "  --out DIR          directory to write data/items.csv, data/deals.csv and input/carts.csv to (default traffic)" << std::endl;
+    std::cerr << "  --items N          number of items in the catalog (default 10000)" << std::endl;
+    std::cerr << "  --deals N          number of deals in the catalog (default 1000)" << std::endl;
+    std::cerr << "  --min-deal-size N  fewest items in a deal (default 2)" << std::endl;
+    std::cerr << "  --max-deal-size N  most items in a deal (default 5)" << std::endl;
+    std::cerr << "  --deal-overlap P   chance that a deal shares an item with an earlier deal (default 0.1)" << std::endl;
+    std::cerr << "  --deal-types A,B,C relative weights of Buy 2 Get 1, other Buy N Get M and bundle deals (default 6,2,2)" << std::endl;
+    std::cerr << "  --prices D         price distribution: uniform or lognormal (default lognormal)" << std::endl;
+    std::cerr << "  --min-price X      lowest item price (default 0.25)" << std::endl;
+    std::cerr << "  --max-price X      highest item price (default 50.00)" << std::endl;
+    std::cerr << "  --median-price X   median item price of the lognormal distribution (default 3.50)" << std::endl;
+    std::cerr << "  --carts N          number of carts in the stream (default 10000)" << std::endl;
+    std::cerr << "  --mean-lines N     mean number of scanned lines in a cart (default 20)" << std::endl;
+    std::cerr << "  --max-quantity N   largest quantity of a scanned line (default 6)" << std::endl;
+    std::cerr << "  --zipf S           exponent of the Zipf distribution of item popularity, 0 for uniform (default 1.0)" << std::endl;
+    std::cerr << "  --unknown P        chance that a scanned line names an item not in the catalog (default 0)" << std::endl;
+    std::cerr << "  --lanes N          carts scanned at once, whose lines are interleaved in the stream (default 8)" << std::endl;
+    std::cerr << "  --seed N           random seed (default 1)" << std::endl;
+}
+
+/**
+ * Parses a price argument. Throws a std::invalid_argument if it is not a price.
+ * @param value The argument value.
+ * @returns The price.
+*/
+Money parsePrice(const std::string& value) {
+    Money price;
+    if (!Money::parse(value, price)) {
+        throw std::invalid_argument(value);
+    }
+    return price;
+}
+
+/**
+ * Reads the relative weights of the deal types. Throws a std::invalid_argument unless there are
+ * three weights that are not negative and not all 0.
+ * @param dealTypes The weights, separated by commas.
+ * @returns The weights of Buy 2 Get 1, other Buy N Get M and bundle deals.
+*/
+std::vector<double> parseDealTypes(const std::string& dealTypes) {
+    std::vector<double> weights;
+    size_t pos = 0;
+    while (pos <= dealTypes.size()) {
+        size_t comma = std::min(dealTypes.find(',', pos), dealTypes.size());
+        weights.push_back(std::stod(dealTypes.substr(pos, comma - pos)));
+        pos = comma + 1;
+    }
+    if (weights.size() != 3 || std::any_of(weights.begin(), weights.end(), [](double w) { return w < 0; }) ||
+        std::accumulate(weights.begin(), weights.end(), 0.0) <= 0) {
+        throw std::invalid_argument(dealTypes);
+    }
+    return weights;
+}
+
+/**
+ * Reads the generator parameters from the command line arguments.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @returns The parameters.
+*/
+TrafficConfig parseArguments(int argc, char* argv[]) {
+    TrafficConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 == argc) {
+            throw std::runtime_error("Missing value for argument '" + arg + "'.");
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--out") config.outDir = value;
+            else if (arg == "--items") config.itemCount = std::stoi(value);
+            else if (arg == "--deals") config.dealCount = std::stoi(value);
+            else if (arg == "--min-deal-size") config.minDealSize = std::stoi(value);
+            else if (arg == "--max-deal-size") config.maxDealSize = std::stoi(value);
+            else if (arg == "--deal-overlap") config.dealOverlap = std::stod(value);
+            else if (arg == "--deal-types") config.dealTypes = parseDealTypes(value);
+            else if (arg == "--prices") config.prices = value;
+            else if (arg == "--min-price") config.minPrice = parsePrice(value);
+            else if (arg == "--max-price") config.maxPrice = parsePrice(value);
+            else if (arg == "--median-price") config.medianPrice = parsePrice(value);
+            else if (arg == "--carts") config.cartCount = std::stoi(value);
+            else if (arg == "--mean-lines") config.meanLines = std::stoi(value);
+            else if (arg == "--max-quantity") config.maxQuantity = std::stoi(value);
+            else if (arg == "--zipf") config.zipf = std::stod(value);
+            else if (arg == "--unknown") config.unknownScans = std::stod(value);
+            else if (arg == "--lanes") config.lanes = std::stoi(value);
+            else if (arg == "--seed") config.seed = std::stoull(value);
+            else throw std::runtime_error("Unknown argument '" + arg + "'.");
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid value '" + value + "' for argument '" + arg + "'.");
+        }
+    }
+
+    // Check the parameters describe a valid catalog and stream
+    if (config.itemCount < 1 || config.dealCount < 0 || config.minDealSize < 1 || config.cartCount < 0 ||
+        config.meanLines < 1 || config.maxQuantity < 1 || config.lanes < 1) {
+        throw std::runtime_error("Counts and sizes must be positive.");
+    }
+    if (config.maxDealSize < config.minDealSize) {
+        throw std::runtime_error("The largest deal size must be at least the smallest.");
+    }
+    if (static_cast<long long>(config.dealCount) * config.minDealSize > config.itemCount) {
+        throw std::runtime_error("Deals need more items than the catalog has.");
+    }
+    if (config.dealOverlap < 0 || config.dealOverlap > 1 || config.unknownScans < 0 || config.unknownScans > 1) {
+        throw std::runtime_error("Chances must be between 0 and 1.");
+    }
+    if (config.zipf < 0) {
+        throw std::runtime_error("The Zipf exponent must not be negative.");
+    }
+    if (config.minPrice < Money(1) || config.maxPrice < config.minPrice) {
+        throw std::runtime_error("Prices must be at least 0.01, and the highest price at least the lowest.");
+    }
+    if (config.prices != "uniform" && config.prices != "lognormal") {
+        throw std::runtime_error("Unknown price distribution '" + config.prices + "'.");
+    }
+    return config;
+}
+
+/**
+ * Gets the name of a generated item from a few words, numbered so every name is unique.
+ * @param itemId The item id.
+ * @returns The item name, already in Camel Case.
+*/
+std::string itemName(int itemId) {
+    static const char* kinds[] = {"Organic", "Fresh", "Frozen", "Whole", "Classic", "Family Size", "Low Fat", "Smoked"};
+    static const char* products[] = {"Apples", "Bread", "Cheddar", "Coffee", "Eggs", "Granola", "Milk", "Pasta",
+                                     "Rice", "Salsa", "Soda", "Spinach", "Tea", "Tomatoes", "Tortillas", "Yogurt"};
+    return std::string(kinds[itemId % 8]) + ' ' + products[itemId / 8 % 16] + ' ' + std::to_string(itemId);
+}
+
+/**
+ * Formats an amount of cents as a price of the catalog files.
+ * @param cents The amount in cents.
+ * @returns The price.
+*/
+std::string formatPrice(std::int64_t cents) {
+    return std::to_string(cents / 100) + '.' + std::to_string(cents % 100 / 10) + std::to_string(cents % 10);
+}
+
+/**
+ * Draws ranks from 0 to a count - 1 with probability proportional to 1 / (rank + 1)^s, by binary
+ * search over the cumulative weights. An exponent of 0 draws every rank equally often.
+*/
+class ZipfDistribution {
+    private:
+        /**
+         * The cumulative weight of each rank and all ranks before it.
+        */
+        std::vector<double> cumulative;
+
+    public:
+        /**
+         * Instantiates a distribution.
+         * @param count The number of ranks.
+         * @param exponent The exponent s.
+        */
+        ZipfDistribution(int count, double exponent) : cumulative(count) {
+            double total = 0;
+            for (int rank = 0; rank < count; rank++) {
+                total += std::pow(rank + 1.0, -exponent);
+                cumulative[rank] = total;
+            }
+        }
+
+        /**
+         * Draws a rank.
+         * @param rng The random number generator.
+         * @returns The rank.
+        */
+        int operator()(std::mt19937_64& rng) const {
+            double weight = std::uniform_real_distribution<double>(0, cumulative.back())(rng);
+            size_t rank = std::upper_bound(cumulative.begin(), cumulative.end(), weight) - cumulative.begin();
+            return static_cast<int>(std::min(rank, cumulative.size() - 1));
+        }
+};
+
+/**
+ * Writes a catalog of items with random prices and deals of random sizes and types. Each deal takes
+ * items no other deal has yet, except that with the overlap chance one of them is replaced by an item
+ * of an earlier deal, so deals form small clusters rather than one cluster spanning the catalog.
+ * @param config The generator parameters.
+ * @param rng The random number generator.
+ * @param itemsPath The path of the items file.
+ * @param dealsPath The path of the deals file.
+ * @param summary Counts the items and deals written.
+*/
+void generateCatalog(const TrafficConfig& config, std::mt19937_64& rng, const std::string& itemsPath,
+                     const std::string& dealsPath, TrafficSummary& summary) {
+    std::uniform_int_distribution<std::int64_t> uniformCents(config.minPrice.getCents(), config.maxPrice.getCents());
+    std::lognormal_distribution<double> lognormalCents(std::log(static_cast<double>(config.medianPrice.getCents())), 1.0);
+
+    // Write items with prices from the chosen distribution, clamped to the price range
+    std::vector<std::int64_t> prices(config.itemCount);
+    std::ofstream items(itemsPath);
+    items << "Item,Price\n";
+    for (int id = 0; id < config.itemCount; id++) {
+        std::int64_t cents = config.prices == "uniform" ? uniformCents(rng) : std::llround(lognormalCents(rng));
+        prices[id] = std::clamp(cents, config.minPrice.getCents(), config.maxPrice.getCents());
+        items << itemName(id) << ',' << formatPrice(prices[id]) << '\n';
+    }
+    summary.items = config.itemCount;
+
+    // Take deal items from a shuffled order of all items, so deals are unrelated to popularity
+    std::vector<int> unusedItems(config.itemCount);
+    std::iota(unusedItems.begin(), unusedItems.end(), 0);
+    std::shuffle(unusedItems.begin(), unusedItems.end(), rng);
+    size_t nextUnused = 0;
+
+    std::discrete_distribution<int> dealType(config.dealTypes.begin(), config.dealTypes.end());
+    std::uniform_int_distribution<int> dealSize(config.minDealSize, config.maxDealSize);
+    std::bernoulli_distribution overlaps(config.dealOverlap);
+    std::uniform_int_distribution<int> buyCount(1, 4);
+    std::uniform_int_distribution<int> freeCount(1, 2);
+    std::uniform_int_distribution<int> bundlePercent(70, 90);
+
+    std::ofstream deals(dealsPath);
+    deals << "Deal\n";
+    std::vector<int> dealItems;
+    std::vector<int> usedItems;
+    for (int deal = 0; deal < config.dealCount; deal++) {
+        // Draw the items, leaving enough unused items for the smallest size of every later deal
+        size_t reserved = static_cast<size_t>(config.dealCount - deal - 1) * config.minDealSize;
+        size_t size = std::min<size_t>(dealSize(rng), config.itemCount - nextUnused - reserved);
+        dealItems.assign(unusedItems.begin() + nextUnused, unusedItems.begin() + nextUnused + size);
+        nextUnused += size;
+        bool isOverlapping = !usedItems.empty() && overlaps(rng);
+        if (isOverlapping) {
+            dealItems[0] = usedItems[std::uniform_int_distribution<size_t>(0, usedItems.size() - 1)(rng)];
+        }
+        usedItems.insert(usedItems.end(), dealItems.begin() + isOverlapping, dealItems.end());
+
+        // Write the terms, Buy 2 Get 1 being the default of a line without terms. Bundles hold one
+        // unit of each item, so larger deals than a deal group allows stay Buy 2 Get 1.
+        int type = dealType(rng);
+        if (type == 2 && dealItems.size() > static_cast<size_t>(Deal::maxGroupSize)) {
+            type = 0;
+        }
+        if (type == 1) {
+            deals << "Buy " << buyCount(rng) << " Get " << freeCount(rng) << ": ";
+        } else if (type == 2) {
+            std::int64_t regularCents = 0;
+            for (int itemId : dealItems) {
+                regularCents += prices[itemId];
+            }
+            deals << "Bundle " << formatPrice(regularCents * bundlePercent(rng) / 100) << ": ";
+        }
+        for (size_t i = 0; i < dealItems.size(); i++) {
+            deals << (i > 0 ? "," : "") << itemName(dealItems[i]);
+        }
+        deals << '\n';
+    }
+    summary.deals = config.dealCount;
+
+    if (!items || !deals) {
+        throw std::runtime_error("Cannot write the catalog to: '" + itemsPath + "'.");
+    }
+}
+
+/**
+ * Writes a stream of carts in the batch cart format. Items are drawn by a Zipf distribution over a
+ * random popularity order of the catalog, and cart sizes and quantities are geometric. Up to one
+ * cart per lane is open at a time, and each line of the stream continues a random open cart, so
+ * the lines of carts being scanned at once are interleaved. Cart ids increase in the order carts open.
+ * @param config The generator parameters.
+ * @param rng The random number generator.
+ * @param cartsPath The path of the carts file.
+ * @param summary Counts the carts and lines written.
+*/
+void generateCarts(const TrafficConfig& config, std::mt19937_64& rng, const std::string& cartsPath, TrafficSummary& summary) {
+    std::vector<int> itemOfRank(config.itemCount);
+    std::iota(itemOfRank.begin(), itemOfRank.end(), 0);
+    std::shuffle(itemOfRank.begin(), itemOfRank.end(), rng);
+    ZipfDistribution popularity(config.itemCount, config.zipf);
+
+    std::geometric_distribution<int> extraLines(1.0 / config.meanLines);
+    std::geometric_distribution<int> extraUnits(0.6);
+    std::bernoulli_distribution isUnknown(config.unknownScans);
+
+    // Each open cart's id and remaining lines
+    struct OpenCart {
+        int id;
+        int linesLeft;
+    };
+    std::vector<OpenCart> openCarts;
+    int nextCartId = 1;
+    auto openCart = [&]() {
+        openCarts.push_back({nextCartId++, 1 + extraLines(rng)});
+    };
+    while (static_cast<int>(openCarts.size()) < config.lanes && nextCartId <= config.cartCount) {
+        openCart();
+    }
+
+    std::ofstream carts(cartsPath);
+    carts << "Cart,Item,Quantity\n";
+    while (!openCarts.empty()) {
+        // Scan the next line of a random open cart, replacing the cart with a new one once it is done
+        size_t lane = std::uniform_int_distribution<size_t>(0, openCarts.size() - 1)(rng);
+        OpenCart& cart = openCarts[lane];
+        int quantity = std::min(1 + extraUnits(rng), config.maxQuantity);
+        if (isUnknown(rng)) {
+            carts << cart.id << ",Unknown Item " << summary.unknownLines++ << ',' << quantity << '\n';
+        } else {
+            carts << cart.id << ',' << itemName(itemOfRank[popularity(rng)]) << ',' << quantity << '\n';
+        }
+        summary.lines++;
+
+        if (--cart.linesLeft == 0) {
+            summary.carts++;
+            openCarts[lane] = openCarts.back();
+            openCarts.pop_back();
+            if (nextCartId <= config.cartCount) {
+                openCart();
+            }
+        }
+    }
+
+    if (!carts) {
+        throw std::runtime_error("Cannot write the carts to: '" + cartsPath + "'.");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    TrafficConfig config;
+    try {
+        config = parseArguments(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    TrafficSummary summary;
+    try {
+        // Lay the files out like the program's own, so the output directory can also be checked out with -b
+        std::filesystem::path dir(config.outDir);
+        std::filesystem::create_directories(dir / "data");
+        std::filesystem::create_directories(dir / "input");
+
+        // Draw the catalog and the carts from separate generators, so changing the carts keeps the catalog
+        std::mt19937_64 catalogRng(config.seed);
+        std::mt19937_64 cartRng(config.seed ^ 0x9E3779B97F4A7C15ULL);
+        generateCatalog(config, catalogRng, (dir / "data" / "items.csv").string(), (dir / "data" / "deals.csv").string(), summary);
+        generateCarts(config, cartRng, (dir / "input" / "carts.csv").string(), summary);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "{\"out\": \"" << config.outDir << "\", \"seed\": " << config.seed << ", \"items\": " << summary.items
+              << ", \"deals\": " << summary.deals << ", \"carts\": " << summary.carts << ", \"lines\": " << summary.lines
+              << ", \"unknown_lines\": " << summary.unknownLines << "}" << std::endl;
+    return 0;
+}
@@ -0,0 +1,503 @@
+#include "catalog.h"
+#include "checkout_register.h"
+#include "checkout_stats.h"
+#include "receipt_sink.h"
+#include "mapped_file.h"
+#include "io_helper.h"
+#include "journal.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifndef CHECKOUT_STATS
+namespace {
+    /**
+     * The number of heap allocations made by the calling thread, counted by the global operator new below.
+     * Builds with checkout statistics count allocations in CheckoutStats instead.
+    */
+    thread_local size_t allocationCount = 0;
+}
+
+/**
+ * Gets the number of heap allocations made so far by the calling thread.
+*/
+size_t allocations() {
+    return allocationCount;
+}
+
+// GCC inlines the deletes below next to new expressions in this file and, not seeing that the
+// operator new above allocates with malloc, warns that the memory is released with free
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+#else
+size_t allocations() {
+    return CheckoutStats::threadAllocations();
+}
+#endif
+
+/**
+ * A stream buffer that discards everything written to it, so receipts can be formatted without
+ * measuring the cost of a terminal or file.
+*/
+class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+/**
+ * Parameters of a replay.
+*/
+struct ReplayConfig {
+    std::string dir = ".";
+    double rate = 0;
+    int threads = 1;
+    long long warmup = 0;
+    std::string format = "text";
+    std::string journalPath;
+};
+
+/**
+ * A single event of the replayed stream: the scan of a cart line, or the checkout of a cart after
+ * its last line.
+*/
+struct ReplayEvent {
+    /**
+     * The index of the cart in the order carts first appear in the stream.
+    */
+    int cart;
+
+    /**
+     * The scanned item name, pointing into the mapped carts file. Empty for a checkout.
+    */
+    std::string_view itemName;
+
+    /**
+     * The scanned quantity, 0 if the line's quantity is not a number, or -1 for a checkout.
+    */
+    int quantity;
+};
+
+/**
+ * The events of a carts file, and the id of each of its carts.
+*/
+struct ReplayStream {
+    std::vector<ReplayEvent> events;
+    std::vector<int> cartIds;
+};
+
+/**
+ * The measurements of the events replayed by one thread.
+*/
+struct ReplayResult {
+    std::vector<std::uint64_t> scanNs;
+    std::vector<std::uint64_t> checkoutNs;
+    long long rejectedScans = 0;
+    size_t allocations = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::time_point::max();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::time_point::min();
+};
+
+/**
+ * Prints the command line usage of the replay driver to the standard error.
+*/
+void printUsage() {
+    std::cerr << "Usage: supermarket_replay_traffic [options]" << std::endl;
+    std::cerr << "  --dir DIR          directory holding data/items.csv, data/deals.csv and input/carts.csv (default .)" << std::endl;
+    std::cerr << "  --rate N           events (scans and checkouts) per second to replay at, 0 for as fast as possible (default 0)" << std::endl;
+    std::cerr << "  --threads N        threads replaying carts, each with its own registers (default 1)" << std::endl;
+    std::cerr << "  --warmup N         events replayed before measuring starts (default 0)" << std::endl;
+    std::cerr << "  --format F         receipt format: text, jsonl or binary (default text)" << std::endl;
+    std::cerr << "  --journal PATH     journal every event to a file, as the program does with --journal" << std::endl;
+}
+
+/**
+ * Reads the replay parameters from the command line arguments.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @returns The parameters.
+*/
+ReplayConfig parseArguments(int argc, char* argv[]) {
+    ReplayConfig config;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 == argc) {
+            throw std::runtime_error("Missing value for argument '" + arg + "'.");
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--dir") config.dir = value;
+            else if (arg == "--rate") config.rate = std::stod(value);
+            else if (arg == "--threads") config.threads = std::stoi(value);
+            else if (arg == "--warmup") config.warmup = std::stoll(value);
+            else if (arg == "--format") config.format = value;
+            else if (arg == "--journal") config.journalPath = value;
+            else throw std::runtime_error("Unknown argument '" + arg + "'.");
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid value '" + value + "' for argument '" + arg + "'.");
+        }
+    }
+
+    // Check the parameters describe a valid replay
+    ReceiptFormat format;
+    if (config.rate < 0 || config.threads < 1 || config.warmup < 0) {
+        throw std::runtime_error("Rates and counts must not be negative, and there must be a thread.");
+    }
+    if (!ReceiptSink::parseFormat(config.format, format)) {
+        throw std::runtime_error("Unknown receipt format '" + config.format + "'.");
+    }
+    return config;
+}
+
+/**
+ * Reads the events of a carts file in the batch cart format, `cartId,itemName,quantity`, in file
+ * order. Each cart is checked out right after its last line.
+ * @param contents The contents of the file, which must stay valid while the events are used.
+ * @param filepath The path of the file, for error messages.
+ * @returns The events.
+*/
+ReplayStream readStream(std::string_view contents, const std::string& filepath) {
+    // Read the lines, skipping the header line
+    struct Line {
+        int cart;
+        std::string_view itemName;
+        int quantity;
+    };
+    std::vector<Line> lines;
+    std::vector<size_t> lastLineOfCart;
+    std::unordered_map<int, int> indexOfCart;
+    ReplayStream stream;
+
+    size_t pos = 0;
+    std::string_view line;
+    IOHelper::nextField(contents, pos, '\n', line);
+    while (IOHelper::nextField(contents, pos, '\n', line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        std::string_view cartIdStr, itemName, quantityStr;
+        size_t fieldPos = 0;
+        IOHelper::nextField(line, fieldPos, ',', cartIdStr);
+        IOHelper::nextField(line, fieldPos, ',', itemName);
+        IOHelper::nextField(line, fieldPos, ',', quantityStr);
+
+        int cartId;
+        if (IOHelper::parseInt(cartIdStr, cartId) != IOHelper::ParseStatus::Ok) {
+            throw std::runtime_error("Invalid cart id: '" + std::string(cartIdStr) + "' in file: '" + filepath + "'.");
+        }
+        auto it = indexOfCart.emplace(cartId, static_cast<int>(stream.cartIds.size())).first;
+        if (it->second == static_cast<int>(stream.cartIds.size())) {
+            stream.cartIds.push_back(cartId);
+            lastLineOfCart.push_back(0);
+        }
+
+        // Lines with an invalid quantity are scanned with a quantity of 0, which the register rejects
+        int quantity = 0;
+        IOHelper::parseInt(quantityStr, quantity);
+        lastLineOfCart[it->second] = lines.size();
+        lines.push_back({it->second, itemName, quantity});
+    }
+
+    // Follow the last line of each cart with its checkout
+    stream.events.reserve(lines.size() + stream.cartIds.size());
+    for (size_t i = 0; i < lines.size(); i++) {
+        stream.events.push_back({lines[i].cart, lines[i].itemName, lines[i].quantity});
+        if (lastLineOfCart[lines[i].cart] == i) {
+            stream.events.push_back({lines[i].cart, std::string_view(), -1});
+        }
+    }
+    return stream;
+}
+
+/**
+ * Gets the memory of the process resident in RAM.
+ * @param isPeak Whether to get the most memory that has been resident at once, rather than the current amount.
+ * @returns The size in bytes, or 0 if it cannot be read on this platform.
+*/
+size_t residentBytes(bool isPeak) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return isPeak ? counters.PeakWorkingSetSize : counters.WorkingSetSize;
+#else
+    if (isPeak) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+    std::ifstream statm("/proc/self/statm");
+    size_t pages, residentPages;
+    if (!(statm >> pages >> residentPages)) {
+        return 0;
+    }
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/**
+ * Replays the events of one thread's carts in stream order through its own registers, one register
+ * per cart open at once. If a rate is set, each event waits until its time in the stream, and its
+ * latency is measured from that time rather than from when it started, so falling behind shows in
+ * the latencies instead of slowing the stream down.
+ * @param config The replay parameters.
+ * @param catalog The catalog.
+ * @param stream The stream.
+ * @param eventIndexes The indexes of the events of the thread's carts, in stream order.
+ * @param journal The journal for the registers, or nullptr.
+ * @param firstRegisterId The journal id of the thread's first register.
+ * @param start The time of the first event of the stream.
+ * @param result The measurements.
+*/
+void replayEvents(const ReplayConfig& config, const Catalog& catalog, const ReplayStream& stream,
+                  const std::vector<size_t>& eventIndexes, Journal* journal, std::uint32_t firstRegisterId,
+                  std::chrono::steady_clock::time_point start, ReplayResult& result) {
+    // Create a register for every cart the thread has open at once before measuring
+    int openCarts = 0;
+    int registerCount = 0;
+    std::vector<bool> isCartOpen(stream.cartIds.size(), false);
+    for (size_t index : eventIndexes) {
+        const ReplayEvent& event = stream.events[index];
+        if (event.quantity == -1) {
+            isCartOpen[event.cart] = false;
+            openCarts--;
+        } else if (!isCartOpen[event.cart]) {
+            isCartOpen[event.cart] = true;
+            registerCount = std::max(registerCount, ++openCarts);
+        }
+    }
+
+    std::vector<std::unique_ptr<CheckoutRegister>> registers;
+    std::vector<CheckoutRegister*> idleRegisters;
+    for (int i = 0; i < registerCount; i++) {
+        registers.emplace_back(new CheckoutRegister(catalog));
+        registers.back()->setJournal(journal, firstRegisterId + i);
+        idleRegisters.push_back(registers.back().get());
+    }
+    std::vector<CheckoutRegister*> registerOfCart(stream.cartIds.size(), nullptr);
+
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+    ReceiptFormat format;
+    ReceiptSink::parseFormat(config.format, format);
+    std::unique_ptr<ReceiptSink> sink = ReceiptSink::create(format, nullStream);
+    result.scanNs.reserve(eventIndexes.size());
+    result.checkoutNs.reserve(eventIndexes.size());
+    size_t allocationsBefore = 0;
+    std::chrono::duration<double, std::nano> interval(config.rate > 0 ? 1e9 / config.rate : 0);
+    const std::chrono::microseconds sleepMargin(200);
+
+    for (size_t index : eventIndexes) {
+        const ReplayEvent& event = stream.events[index];
+        bool isMeasured = static_cast<long long>(index) >= config.warmup;
+
+        // Wait for the event's time in the stream
+        auto scheduled = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval * static_cast<double>(index));
+        auto begin = std::chrono::steady_clock::now();
+        if (config.rate > 0) {
+            // Sleeps can overshoot by tens of microseconds, so only sleep until shortly before the event
+            if (scheduled - begin > sleepMargin) {
+                std::this_thread::sleep_until(scheduled - sleepMargin);
+            }
+            while (std::chrono::steady_clock::now() < scheduled) {
+                std::this_thread::yield();
+            }
+            begin = scheduled;
+        }
+        if (isMeasured && result.start == std::chrono::steady_clock::time_point::max()) {
+            result.start = begin;
+            allocationsBefore = allocations();
+        }
+
+        // Scan on the cart's register, taking an idle one on its first scan, or check it out and release the register
+        CheckoutRegister*& reg = registerOfCart[event.cart];
+        if (reg == nullptr) {
+            reg = idleRegisters.back();
+            idleRegisters.pop_back();
+        }
+        bool isCheckout = event.quantity == -1;
+        if (isCheckout) {
+            reg->checkOut(*sink, stream.cartIds[event.cart]);
+            idleRegisters.push_back(reg);
+            reg = nullptr;
+        } else if (reg->tryScanItem(event.itemName, event.quantity) != ScanStatus::Ok && isMeasured) {
+            result.rejectedScans++;
+        }
+
+        if (isMeasured) {
+            auto end = std::chrono::steady_clock::now();
+            std::uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+            (isCheckout ? result.checkoutNs : result.scanNs).push_back(ns);
+            result.end = end;
+        }
+    }
+    if (result.start != std::chrono::steady_clock::time_point::max()) {
+        result.allocations = allocations() - allocationsBefore;
+    }
+}
+
+/**
+ * Formats the latency percentiles of events as JSON.
+ * @param latencies The latency of each event in nanoseconds, sorted in place.
+ * @returns The JSON object.
+*/
+std::string latencyJson(std::vector<std::uint64_t>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p))];
+    };
+    return "{\"count\": " + std::to_string(latencies.size()) + ", \"p50_ns\": " + std::to_string(percentile(0.5))
+        + ", \"p90_ns\": " + std::to_string(percentile(0.9)) + ", \"p99_ns\": " + std::to_string(percentile(0.99))
+        + ", \"p999_ns\": " + std::to_string(percentile(0.999))
+        + ", \"max_ns\": " + std::to_string(latencies.empty() ? 0 : latencies.back()) + "}";
+}
+
+int main(int argc, char* argv[]) {
+    ReplayConfig config;
+    try {
+        config = parseArguments(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    try {
+        // Load the catalog
+        std::string itemsPath = config.dir + "/data/items.csv";
+        std::string dealsPath = config.dir + "/data/deals.csv";
+        std::string cartsPath = config.dir + "/input/carts.csv";
+        auto loadStart = std::chrono::steady_clock::now();
+        Catalog catalog;
+        catalog.readItemsFromFile(itemsPath);
+        catalog.readDealsFromFile(dealsPath);
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+        // Read the stream, and shard its carts over the threads
+        MappedFile cartsFile(cartsPath);
+        if (!cartsFile.isOpen()) {
+            throw std::runtime_error("Cannot open file: '" + cartsPath + "'. Please ensure it exists.");
+        }
+        ReplayStream stream = readStream(cartsFile.contents(), cartsPath);
+        std::vector<std::vector<size_t>> threadEvents(config.threads);
+        for (size_t i = 0; i < stream.events.size(); i++) {
+            threadEvents[stream.events[i].cart % config.threads].push_back(i);
+        }
+
+        std::unique_ptr<Journal> journal;
+        if (!config.journalPath.empty()) {
+            journal.reset(new Journal(config.journalPath));
+        }
+
+        // Replay every thread's events against the same clock, using the calling thread as the last thread
+        std::vector<ReplayResult> results(config.threads);
+        std::vector<std::thread> threads;
+        std::uint32_t registerIdStride = static_cast<std::uint32_t>(stream.cartIds.size());
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 1; i < config.threads; i++) {
+            threads.emplace_back(replayEvents, std::cref(config), std::cref(catalog), std::cref(stream), std::cref(threadEvents[i]),
+                                 journal.get(), i * registerIdStride, start, std::ref(results[i]));
+        }
+        replayEvents(config, catalog, stream, threadEvents[0], journal.get(), 0, start, results[0]);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        if (journal) {
+            journal->publish();
+        }
+
+        // Combine the measurements of all threads
+        std::vector<std::uint64_t> scanNs, checkoutNs;
+        long long rejectedScans = 0;
+        size_t totalAllocations = 0;
+        auto measureStart = std::chrono::steady_clock::time_point::max();
+        auto measureEnd = std::chrono::steady_clock::time_point::min();
+        for (ReplayResult& result : results) {
+            scanNs.insert(scanNs.end(), result.scanNs.begin(), result.scanNs.end());
+            checkoutNs.insert(checkoutNs.end(), result.checkoutNs.begin(), result.checkoutNs.end());
+            rejectedScans += result.rejectedScans;
+            totalAllocations += result.allocations;
+            measureStart = std::min(measureStart, result.start);
+            measureEnd = std::max(measureEnd, result.end);
+        }
+        double seconds = measureStart < measureEnd ? std::chrono::duration<double>(measureEnd - measureStart).count() : 0;
+        long long events = scanNs.size() + checkoutNs.size();
+        size_t rssBytes = residentBytes(false);
+
+        char number[64];
+        auto fixed = [&number](double value) {
+            std::snprintf(number, sizeof(number), "%.2f", value);
+            return std::string(number);
+        };
+        std::cout << "{\n";
+        std::cout << "  \"config\": {\"dir\": \"" << config.dir << "\", \"rate\": " << fixed(config.rate)
+                  << ", \"threads\": " << config.threads << ", \"warmup\": " << config.warmup
+                  << ", \"format\": \"" << config.format << "\", \"journal\": " << (journal ? "true" : "false") << "},\n";
+        std::cout << "  \"catalog\": {\"items\": " << catalog.getItemCount() << ", \"deals\": " << catalog.getDealCount()
+                  << ", \"load_ms\": " << fixed(loadMs) << ", \"bytes\": " << catalog.getMemoryUsage().total() << "},\n";
+        std::cout << "  \"replay\": {\"events\": " << events << ", \"scans\": " << scanNs.size()
+                  << ", \"rejected_scans\": " << rejectedScans << ", \"carts\": " << checkoutNs.size()
+                  << ", \"seconds\": " << fixed(seconds) << ", \"events_per_sec\": " << fixed(seconds > 0 ? events / seconds : 0)
+                  << ", \"carts_per_sec\": " << fixed(seconds > 0 ? checkoutNs.size() / seconds : 0)
+                  << ", \"allocations\": " << totalAllocations
+                  << ", \"allocs_per_cart\": " << fixed(checkoutNs.empty() ? 0 : static_cast<double>(totalAllocations) / checkoutNs.size())
+                  << ", \"rss_bytes\": " << rssBytes << ", \"peak_rss_bytes\": " << std::max(rssBytes, residentBytes(true)) << "},\n";
+        std::cout << "  \"latency\": {\"scan\": " << latencyJson(scanNs) << ",\n";
+        std::cout << "              \"checkout\": " << latencyJson(checkoutNs) << "}\n";
+        std::cout << "}" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}